@@ -6,6 +6,22 @@
 #include <conio.h>
 #include <vector>
 #include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <cmath>
+#include <cwchar>
+#include <cwctype>
+#include <climits>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <queue>
 
 #define KEY_ENTER		13	// '\r'
 #define KEY_SPACEBAR	32	// ' '
@@ -13,6 +29,17 @@
 #define KEY_ARROW_LEFT	75	// 'K'
 #define KEY_ARROW_RIGHT 77	// 'M'
 #define KEY_ARROW_DOWN	80	// 'P'
+#define KEY_BACKSPACE	8	// '\b'
+#define KEY_TAB			9	// '\t'
+#define KEY_ESCAPE		27
+#define KEY_HOME		71	// 'G'
+#define KEY_END			79	// 'O'
+#define KEY_DELETE		83	// 'S'
+#define KEY_SORT		115	// 's'
+
+// prefixes of extended keys (arrows, home, delete, ...), followed by the key itself
+#define KEY_FUNCTION_PREFIX	0
+#define KEY_EXTENDED_PREFIX	224
 
 // Undefine min/max macro of windows.h
 // --> due to conflict with numeric_limits::min() / numeric_limits::max()
@@ -28,6 +55,25 @@ const int	DEFAULT_OPTIONS_PER_PAGE	= 10;
 const char	DEFAULT_CURSOR_STYLE		= L'>';
 const int	TRUNC_CHARS					= 5;
 const std::wstring NO_INSTRUCTION		= L"";
+const size_t DEFAULT_DESCRIPTION_CACHE_SIZE	= 64;
+const std::wstring PENDING_DESCRIPTION	= L"...";
+const int	DEFAULT_MAX_FRAME_RATE		= 60;
+const int	MAX_FRAME_INTERVAL_MS		= 1000;
+const int	DEFAULT_LIVE_REFRESH_RATE	= 10;
+const size_t ROW_CACHE_SIZE				= 1024;
+const int	DEFAULT_SESSION_LINE_SIZE	= 80;
+const DWORD	SESSION_READ_BUFFER_SIZE	= 256;
+const int	DEFAULT_MAX_COMPLETIONS		= 5;
+const int	COMPLETION_BUCKET_SIZE		= 16;
+const size_t INITIAL_GAP_SIZE			= 64;
+const int	DEFAULT_MAX_COLUMN_WIDTH	= 24;
+const int	COLUMN_WIDTH_SAMPLE_SIZE	= 1024;
+const int	COLUMN_SPACING				= 2;
+
+
+// computes description of an option, on demand.
+// (invoked from a background thread - must not touch the menu itself)
+typedef std::function<std::wstring()> DescriptionProvider;
 
 
 class Option
@@ -46,6 +92,16 @@ public:
 	// grant 'BasicMenu' and derived classes access to private methods/members
 	friend class BasicMenu;
 
+private:
+	// only friend classes can create a key.
+	// (lets containers construct options in place)
+	struct ConstructionKey { explicit ConstructionKey() {} };
+
+public:
+	// c-tor, strings are moved in
+	Option(ConstructionKey, std::wstring&& optName, std::wstring&& optDescription, BOOL isSelected)
+		: _displayName(std::move(optName)), _description(std::move(optDescription)), _selected(isSelected) {};
+
 	// d-tor
 	~Option() {}
 
@@ -64,6 +120,15 @@ protected:
 };
 
 
+// entry of 'BasicMenu::addOptions()'
+struct OptionEntry
+{
+	std::wstring displayName;
+	std::wstring description;
+	BOOL isSelectedByDefault;
+};
+
+
 struct MenuState
 {
 	std::vector<Option> options;
@@ -92,776 +157,5242 @@ private:
 	MenuState(std::vector<Option>& options) : options(options) {}
 };
 
+inline BOOL isHighSurrogate(wchar_t c) {
+	return c >= 0xD800 && c <= 0xDBFF;
+}
+
+inline BOOL isLowSurrogate(wchar_t c) {
+	return c >= 0xDC00 && c <= 0xDFFF;
+}
+
+// number of console columns occupied by a character.
+// East Asian wide / fullwidth characters take 2 columns, everything else 1 -
+// including each half of a surrogate pair, so pairs (mostly emoji) take 2 as well.
+inline int getCharWidth(wchar_t c)
+{
+	BOOL isWide =
+		(c >= 0x1100 && c <= 0x115F) ||	// hangul jamo
+		(c >= 0x2E80 && c <= 0xA4CF) ||	// CJK ... yi
+		(c >= 0xAC00 && c <= 0xD7A3) ||	// hangul syllables
+		(c >= 0xF900 && c <= 0xFAFF) ||	// CJK compatibility ideographs
+		(c >= 0xFE30 && c <= 0xFE4F) ||	// CJK compatibility forms
+		(c >= 0xFF00 && c <= 0xFF60) ||	// fullwidth forms
+		(c >= 0xFFE0 && c <= 0xFFE6);
+	return isWide ? 2 : 1;
+}
+
+// number of console columns occupied by a string
+inline int getDisplayWidth(const wchar_t* str, size_t len)
+{
+	int width = 0;
+	for (size_t i = 0; i < len; i++) {
+		width += getCharWidth(str[i]);
+	}
+	return width;
+}
+
+// longest prefix of 'str' within 'maxWidth' columns, without splitting surrogate pairs.
+// 'width' receives columns of the prefix.
+inline size_t getFittingLength(const wchar_t* str, size_t len, int maxWidth, int& width)
+{
+	size_t fittingLen = 0;
+	width = 0;
+	while (fittingLen < len) {
+		size_t charLen = (isHighSurrogate(str[fittingLen]) && fittingLen + 1 < len &&
+			isLowSurrogate(str[fittingLen + 1])) ? 2 : 1;
+		int charWidth = getDisplayWidth(str + fittingLen, charLen);
+		if (width + charWidth > maxWidth) {
+			break;
+		}
+		fittingLen += charLen;
+		width += charWidth;
+	}
+	return fittingLen;
+}
+
+class BasicMenu;
+class MenuServer;
+
 /// <summary>
-/// most basic menu class
+/// paces frames written to the console.
+/// a frame is due no sooner than 1/maxFrameRate after the previous one, and - when the
+/// output is backpressured (e.g. a congested remote session) - no sooner than the time
+/// it took to write the previous frame, so frames never pile up in the output pipe.
+/// a max frame rate of 0 disables pacing - every frame is painted.
 /// </summary>
-class BasicMenu 
+class FramePacer
 {
 public:
-
-	virtual void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") {
-		m_options.push_back({ optDisplayName, optDescription });
+	FramePacer(int maxFrameRate = DEFAULT_MAX_FRAME_RATE)
+	{
+		LARGE_INTEGER freq;
+		QueryPerformanceFrequency(&freq);
+		m_ticksPerMs = std::max(freq.QuadPart / 1000, (LONGLONG)1);
+		setMaxFrameRate(maxFrameRate);
 	}
 
-	virtual void execute() = 0;
+	void setMaxFrameRate(int maxFrameRate)
+	{
+		m_bPaced = maxFrameRate > 0;
+		m_minIntervalTicks = m_bPaced ? m_ticksPerMs * 1000 / maxFrameRate : 0;
+		if (!m_bPaced) {
+			m_nextFrameTicks = 0;
+		}
+	}
 
-	MenuState getState() {
-		return MenuState(m_options);
+	BOOL isFrameDue() const {
+		return now() >= m_nextFrameTicks;
 	}
 
-private:
-protected:
-	BasicMenu(const std::wstring& menuTitle) : m_title(menuTitle), m_options({}) {}
-	~BasicMenu() {};
+	DWORD getMillisUntilDue() const
+	{
+		LONGLONG remaining = m_nextFrameTicks - now();
+		if (remaining <= 0) {
+			return 0;
+		}
+		return (DWORD)((remaining + m_ticksPerMs - 1) / m_ticksPerMs);
+	}
 
-	std::wstring m_title;
-	std::vector<Option> m_options;
-	int m_menuCursorPos = 0;
+	void beginFrame() {
+		m_frameStartTicks = now();
+	}
 
-	virtual void renderTitle() = 0;
-	virtual void renderOption(int optIdx) = 0;
-	virtual void renderDescription(int optIdx) = 0;
-	virtual void deleteDescription() = 0;
-	// scrolls console down enough line so menu is not torn apart
-	virtual void scrollConsole() = 0;
-	
-	std::wstring truncateString(const std::wstring& str, int maxSize)
+	// expects output to be flushed by now
+	void endFrame()
 	{
-		if (str.size() <= maxSize) {
-			return str;
-		}
-		int maxSizeWithReplacement = maxSize - TRUNC_CHARS;
-		std::wstring truncatedStr = str.substr(0, maxSizeWithReplacement);
-		if (truncatedStr.length() < str.length()) {
-			truncatedStr += L"~" + str.substr(str.length() - TRUNC_CHARS);
+		if (!m_bPaced) {
+			return;
 		}
-		return truncatedStr;
+		LONGLONG frameEndTicks = now();
+		LONGLONG writeTicks = std::min(frameEndTicks - m_frameStartTicks, 
+			m_ticksPerMs * MAX_FRAME_INTERVAL_MS);
+		m_nextFrameTicks = frameEndTicks + std::max(m_minIntervalTicks, writeTicks);
 	}
 
-	void hideConsoleCursor() {
-		HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		CONSOLE_CURSOR_INFO cursorInfo;
-		GetConsoleCursorInfo(hConsole, &cursorInfo);
-		cursorInfo.bVisible = false;
-		SetConsoleCursorInfo(hConsole, &cursorInfo);
+private:
+	LONGLONG m_ticksPerMs;
+	BOOL m_bPaced = TRUE;
+	LONGLONG m_minIntervalTicks = 0;
+	LONGLONG m_frameStartTicks = 0;
+	LONGLONG m_nextFrameTicks = 0;
+
+	static LONGLONG now()
+	{
+		LARGE_INTEGER counter;
+		QueryPerformanceCounter(&counter);
+		return counter.QuadPart;
 	}
+};
 
-	void showConsoleCursor() {
-		HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		CONSOLE_CURSOR_INFO cursorInfo;
-		GetConsoleCursorInfo(hConsole, &cursorInfo);
-		cursorInfo.bVisible = true;
-		SetConsoleCursorInfo(hConsole, &cursorInfo);
+/// <summary>
+/// bounded LRU cache of lazily computed descriptions.
+/// descriptions are computed on a background worker thread - the hovered option first,
+/// then its neighbours. moving on to another option cancels whatever is still queued,
+/// so a slow provider never blocks input.
+/// </summary>
+class DescriptionCache
+{
+public:
+	DescriptionCache(size_t capacity = DEFAULT_DESCRIPTION_CACHE_SIZE)
+		: m_capacity(capacity) {
+		m_hReady = CreateEventW(NULL, FALSE/*auto-reset*/, FALSE, NULL);
 	}
 
-	int getConsoleLineSize() {
-		HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-		CONSOLE_SCREEN_BUFFER_INFO csbi;
-		if (!GetConsoleScreenBufferInfo(hConsole, &csbi)) {
-			return -1;
+	~DescriptionCache()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bStopping = TRUE;
+			m_queueSize = 0;
 		}
-		return csbi.dwSize.X;
+		m_cv.notify_one();
+		if (m_worker.joinable()) {
+			m_worker.join();
+		}
+		CloseHandle(m_hReady);
 	}
 
-	// discard any unread input
-	void clearInputBuffer() {
-		HANDLE hInput = GetStdHandle(STD_INPUT_HANDLE);
-		FlushConsoleInputBuffer(hInput);
-	}
+	DescriptionCache(const DescriptionCache&) = delete;
+	DescriptionCache& operator=(const DescriptionCache&) = delete;
 
-	void clearLine() {
-		std::cout << "\033[2K"; // overwrite current line
-		std::cout << "\033[0G"; // Move cursor to beginning of line
+	void setCapacity(size_t capacity)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_capacity = std::max(capacity, (size_t)1);
+		evict();
 	}
 
-	void clearLeft(int chars) {
-		std::cout << "\033[" << chars << "D"; // Move cursor n characters to the left
-		for (int i = 0; i < chars; ++i) {
-			std::cout << ' '; // overwrite with spaces
-		}
-		std::cout << "\033[" << chars << "D"; // reset console cursor to initial position
+	// signaled once the description of the hovered option is ready
+	HANDLE getReadyEvent() const {
+		return m_hReady;
 	}
 
-	void clearRight(int chars) {
-		for (int i = 0; i < chars; ++i) {
-			std::cout << ' '; // overwrite with spaces
-		}
-		std::cout << "\033[" << chars << "D"; // reset console cursor to initial position
+	// called (on worker thread) along with signaling ready event
+	void setNotifier(const std::function<void()>& notifier)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_notifier = notifier;
 	}
 
-	void moveConsoleCursorLeft(int chars) {
-		if (chars) {
-			std::cout << "\033[" << chars << "D";
-		}
-	}
-	
-	void moveConsoleCursorRight(int chars) {
-		if (chars) {
-			std::cout << "\033[" << chars << "C";
+	// copies cached description into 'description', if ready
+	BOOL lookup(int optIdx, std::wstring& description)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_index.find(optIdx);
+		if (it == m_index.end()) {
+			return FALSE;
 		}
+		m_entries.splice(m_entries.begin(), m_entries, it->second); // mark most recently used
+		description.assign(it->second->second);
+		return TRUE;
 	}
 
-	void moveConsoleCursorUp(int lines) {
-		if (lines) {
-			std::cout << "\033[" << lines << "A";
+	// description of an option, computed by its provider.
+	// (provider is owned by the menu, and outlives the worker)
+	struct Request
+	{
+		int optIdx;
+		const DescriptionProvider* provider;
+	};
+
+	// hovered option and its neighbours
+	static const int MAX_REQUESTS = 3;
+
+	// replaces any queued (now stale) requests with 'requests'.
+	// first request is the hovered option.
+	void request(int hoveredIdx, const Request* requests, int numRequests)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (hoveredIdx == m_hoveredIdx) {
+				return;
+			}
+			m_hoveredIdx = hoveredIdx;
+			m_queueStart = 0;
+			m_queueSize = 0;
+			for (int i = 0; i < numRequests && i < MAX_REQUESTS; i++) {
+				if (m_index.find(requests[i].optIdx) == m_index.end()) {
+					m_queue[m_queueSize++] = requests[i];
+				}
+			}
+			if (m_queueSize == 0) {
+				return;
+			}
+			if (!m_worker.joinable()) {
+				m_worker = std::thread(&DescriptionCache::workerLoop, this);
+			}
 		}
+		m_cv.notify_one();
 	}
 
-	void moveConsoleCursorDown(int lines) {
-		if (lines) {
-			std::cout << "\033[" << lines << "B";
+private:
+	typedef std::list<std::pair<int, std::wstring>> EntryList;
+
+	size_t m_capacity;
+	EntryList m_entries;	// most recently used first
+	std::unordered_map<int, EntryList::iterator> m_index;
+	Request m_queue[MAX_REQUESTS];	// fixed, so requesting never allocates
+	int m_queueStart = 0;
+	int m_queueSize = 0;
+	int m_hoveredIdx = -1;
+	BOOL m_bStopping = FALSE;
+	HANDLE m_hReady;
+	std::function<void()> m_notifier;
+
+	std::mutex m_mutex;
+	std::condition_variable m_cv;
+	std::thread m_worker;
+
+	// expects 'm_mutex' to be held
+	void evict()
+	{
+		while (m_entries.size() > m_capacity) {
+			m_index.erase(m_entries.back().first);
+			m_entries.pop_back();
 		}
 	}
 
-	void toggleOption(Option& option) {
-		option._selected = !option._selected;
-	}
+	void workerLoop()
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		while (true) {
+			m_cv.wait(lock, [this] { return m_bStopping || m_queueSize > 0; });
+			if (m_bStopping) {
+				return;
+			}
+			Request req = m_queue[m_queueStart];
+			m_queueStart++;
+			m_queueSize--;
+			if (m_index.find(req.optIdx) != m_index.end()) {
+				continue;
+			}
 
-	void selectOption(Option& option) {
-		option._selected = TRUE;
-	}
+			// compute without holding the lock, so new requests can cancel queued ones
+			lock.unlock();
+			std::wstring description = (*req.provider)();
+			lock.lock();
 
-	void unselectOption(Option& option) {
-		option._selected = FALSE;
+			if (m_index.find(req.optIdx) == m_index.end()) {
+				m_entries.emplace_front(req.optIdx, std::move(description));
+				m_index[req.optIdx] = m_entries.begin();
+				evict();
+			}
+			if (req.optIdx == m_hoveredIdx) {
+				SetEvent(m_hReady);
+				if (m_notifier) {
+					m_notifier();
+				}
+			}
+		}
 	}
 };
 
 /// <summary>
-/// base class for vertical menus
+/// precompiled, memory mapped catalog of options.
+/// written once from a populated menu, then presented to menus as-is -
+/// no parsing and no per-option allocation on load.
+/// 
+/// file layout:
+///	[ header ][ entry table (one fixed-size entry per option) ][ UTF-16 string blob ]
 /// </summary>
-class VerticalMenu : public BasicMenu
+class OptionCatalog
 {
 public:
-	virtual void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") override {
-		BasicMenu::addOption(optDisplayName, optDescription);
-		m_totalPages = (m_options.size() + m_OPTIONS_PER_PAGE - 1) / m_OPTIONS_PER_PAGE;
-		m_B_USE_PAGING = m_totalPages > 1;
+	OptionCatalog() {}
+	~OptionCatalog() {
+		close();
 	}
 
-private:
+	// owns a file mapping, hence non-copyable
+	OptionCatalog(const OptionCatalog&) = delete;
+	OptionCatalog& operator=(const OptionCatalog&) = delete;
+
+	// serialize options, including their current selections, to a catalog file
+	static BOOL write(const std::wstring& path, BasicMenu& menu);
+	static BOOL write(const std::wstring& path, const MenuState& state) {
+		return writeCatalog(path, (int)state.options.size(),
+			[&state](int idx, const wchar_t*& name, size_t& nameLen,
+				const wchar_t*& desc, size_t& descLen, BOOL& selected) {
+				const Option& opt = state.options[idx];
+				name = opt._displayName.c_str();
+				nameLen = opt._displayName.size();
+				desc = opt._description.c_str();
+				descLen = opt._description.size();
+				selected = opt.IsSelected();
+			});
+	}
 
-	void renderInstruction()
+	// map catalog file to memory.
+	// the view is copy-on-write, so selections made by a menu never touch the file,
+	// unless explicitly stored by 'storeSelections()'.
+	BOOL open(const std::wstring& path)
 	{
-		std::wcout << m_instruction;
+		close();
+		m_path = path;
+		m_hFile = CreateFileW(path.c_str(), GENERIC_READ,
+			FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (m_hFile == INVALID_HANDLE_VALUE) {
+			return FALSE;
+		}
+		LARGE_INTEGER fileSize;
+		if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart < (LONGLONG)sizeof(Header)) {
+			close();
+			return FALSE;
+		}
+		m_hMapping = CreateFileMappingW(m_hFile, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+		if (m_hMapping == NULL) {
+			close();
+			return FALSE;
+		}
+		m_view = (BYTE*)MapViewOfFile(m_hMapping, FILE_MAP_COPY, 0, 0, 0);
+		if (m_view == NULL) {
+			close();
+			return FALSE;
+		}
+
+		// validate header and entries, once. strings are trusted from here on.
+		const Header* header = (const Header*)m_view;
+		if (header->magic != CATALOG_MAGIC || header->version != CATALOG_VERSION ||
+			header->charSize != sizeof(wchar_t) ||
+			header->fileSize != (uint64_t)fileSize.QuadPart ||
+			header->count > INT_MAX ||
+			header->entriesOffset < sizeof(Header) ||
+			header->entriesOffset > header->blobOffset ||
+			header->blobOffset > header->fileSize ||
+			(header->blobOffset - header->entriesOffset) / sizeof(Entry) < header->count ||
+			header->blobOffset % sizeof(wchar_t) != 0
+		) {
+			close();
+			return FALSE;
+		}
+		const Entry* entries = (const Entry*)(m_view + header->entriesOffset);
+		uint64_t blobLength = (header->fileSize - header->blobOffset) / sizeof(wchar_t);
+		for (uint32_t i = 0; i < header->count; i++) {
+			const Entry& entry = entries[i];
+			if ((uint64_t)entry.nameOffset + entry.nameLength > blobLength ||
+				(uint64_t)entry.descOffset + entry.descLength > blobLength ||
+				entry.nameWidth < entry.nameLength || entry.nameWidth > 2 * (uint64_t)entry.nameLength
+			) {
+				close();
+				return FALSE;
+			}
+		}
+		m_count = (int)header->count;
+		m_entries = (Entry*)(m_view + header->entriesOffset);
+		m_blob = (const wchar_t*)(m_view + header->blobOffset);
+		return TRUE;
 	}
 
-	void renderPageInfo(int pageIdx)
+	void close()
 	{
-		int startIdx = pageIdx * m_OPTIONS_PER_PAGE;
-		int endIdx = std::min(startIdx + m_OPTIONS_PER_PAGE, (int)m_options.size());
-		std::wcout << L"[ " << startIdx + 1 << L"-" << endIdx << L" / "
-			<< m_options.size() << L" ]";
+		if (m_view != NULL) {
+			UnmapViewOfFile(m_view);
+		}
+		if (m_hMapping != NULL) {
+			CloseHandle(m_hMapping);
+		}
+		if (m_hFile != INVALID_HANDLE_VALUE) {
+			CloseHandle(m_hFile);
+		}
+		m_view = NULL;
+		m_hMapping = NULL;
+		m_hFile = INVALID_HANDLE_VALUE;
+		m_entries = NULL;
+		m_blob = NULL;
+		m_count = 0;
 	}
 
-protected:
-
-	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage, 
-		const std::wstring& instruction) 
-		: BasicMenu(menuTitle), 
-		m_cursorStyle(cursorStyle), 
-		m_OPTIONS_PER_PAGE(optsPerPage), 
-		m_instruction(instruction) {};
-
-
-	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
-		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, NO_INSTRUCTION) {};
-
-	VerticalMenu(const std::wstring& menuTitle, int optsPerPage,
-		const std::wstring& instruction)
-		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, optsPerPage, instruction) {};
-
-	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
-		const std::wstring& instruction)
-		: VerticalMenu(menuTitle, cursorStyle, DEFAULT_OPTIONS_PER_PAGE, instruction) {};
+	BOOL isOpen() const {
+		return m_view != NULL;
+	}
 
+	int size() const {
+		return m_count;
+	}
 
-	VerticalMenu(const std::wstring& menuTitle, int optsPerPage)
-		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, optsPerPage, 
-			NO_INSTRUCTION) {};
+	const wchar_t* getName(int idx, size_t& len) const {
+		len = m_entries[idx].nameLength;
+		return m_blob + m_entries[idx].nameOffset;
+	}
 
-	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle) 
-		: VerticalMenu(menuTitle, cursorStyle, DEFAULT_OPTIONS_PER_PAGE, 
-			NO_INSTRUCTION) {};
+	const wchar_t* getDescription(int idx, size_t& len) const {
+		len = m_entries[idx].descLength;
+		return m_blob + m_entries[idx].descOffset;
+	}
 
-	VerticalMenu(const std::wstring& menuTitle,	const std::wstring& instruction)
-		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, DEFAULT_OPTIONS_PER_PAGE, 
-			instruction) {};
+	// precomputed at write time, see 'getDisplayWidth()'
+	int getNameWidth(int idx) const {
+		return (int)m_entries[idx].nameWidth;
+	}
 
+	BOOL isSelected(int idx) const {
+		return m_entries[idx].selected ? TRUE : FALSE;
+	}
 
-	VerticalMenu(const std::wstring& menuTitle)	
-		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, DEFAULT_OPTIONS_PER_PAGE, 
-			NO_INSTRUCTION) {};
+	void setSelected(int idx, BOOL selected) {
+		m_entries[idx].selected = selected ? 1 : 0;
+	}
 
-	~VerticalMenu() {};
+	// persist current selections into the catalog file, so the next run starts from them.
+	// (rewrites the entry table only)
+	BOOL storeSelections()
+	{
+		if (!isOpen()) {
+			return FALSE;
+		}
+		const Header* header = (const Header*)m_view;
+		HANDLE hFile = CreateFileW(m_path.c_str(), GENERIC_WRITE,
+			FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE) {
+			return FALSE;
+		}
+		LARGE_INTEGER pos;
+		pos.QuadPart = (LONGLONG)header->entriesOffset;
+		BOOL ok = SetFilePointerEx(hFile, pos, NULL, FILE_BEGIN) &&
+			writeAll(hFile, m_entries, (uint64_t)m_count * sizeof(Entry));
+		CloseHandle(hFile);
+		return ok;
+	}
 
-	std::wstring m_instruction;
-	const wchar_t m_cursorStyle;
-	int m_OPTIONS_PER_PAGE;
-	BOOL m_B_USE_PAGING = FALSE;
-	int m_currentPageIdx = 0;
-	int m_totalPages = 0;
+private:
+	static const uint32_t CATALOG_MAGIC = 0x43505854;	// 'TXPC'
+	static const uint16_t CATALOG_VERSION = 1;
 
-	void scrollConsole() override
+	struct Header
 	{
-		int totalLines = 
-			2/*title*/ + 
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size())/*options*/ +
-			2/*description*/;
-		for (int i = 0; i < totalLines; i++) {
-			std::cout << "\n";
+		uint32_t magic;
+		uint16_t version;
+		uint16_t charSize;		// sizeof(wchar_t) of writer
+		uint32_t count;
+		uint32_t reserved;
+		uint64_t entriesOffset;	// in bytes, from start of file
+		uint64_t blobOffset;	// in bytes, from start of file
+		uint64_t fileSize;
+	};
+
+	struct Entry
+	{
+		uint32_t nameOffset;	// in characters, from start of blob
+		uint32_t nameLength;
+		uint32_t descOffset;	// in characters, from start of blob
+		uint32_t descLength;
+		uint32_t nameWidth;
+		uint8_t selected;
+		uint8_t reserved[3];
+	};
+
+	std::wstring m_path;
+	HANDLE m_hFile = INVALID_HANDLE_VALUE;
+	HANDLE m_hMapping = NULL;
+	BYTE* m_view = NULL;
+	Entry* m_entries = NULL;
+	const wchar_t* m_blob = NULL;
+	int m_count = 0;
+
+	static BOOL writeAll(HANDLE hFile, const void* data, uint64_t size)
+	{
+		const BYTE* ptr = (const BYTE*)data;
+		while (size > 0) {
+			DWORD chunk = (DWORD)std::min<uint64_t>(size, 1 << 30);
+			DWORD written = 0;
+			if (!WriteFile(hFile, ptr, chunk, &written, NULL) || written == 0) {
+				return FALSE;
+			}
+			ptr += written;
+			size -= written;
 		}
-		moveConsoleCursorUp(totalLines);
+		return TRUE;
 	}
 
-	void renderFooter()
+	// 'getOption(idx, name, nameLen, desc, descLen, selected)' fills in option #idx
+	template <typename OptionGetter>
+	static BOOL writeCatalog(const std::wstring& path, int count, OptionGetter getOption)
 	{
-		if (!m_B_USE_PAGING && m_instruction == NO_INSTRUCTION)
-			return;
-
-		// move console cursor to line of footer, and delete
-		moveConsoleCursorDown(
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size())
-			+ 1/*for spacing between options and description*/
-			+ 1/*for description*/);
-		std::cout << "-";
-		clearLine();
-		moveConsoleCursorDown(1);
-		clearLine();
-		moveConsoleCursorUp(1);
-
-		for (int i = 0; i < std::max(m_title.length(), m_instruction.length() + 1); i++) {
-			std::wcout << L"-";
+		Header header = {};
+		header.magic = CATALOG_MAGIC;
+		header.version = CATALOG_VERSION;
+		header.charSize = sizeof(wchar_t);
+		header.count = (uint32_t)count;
+		header.entriesOffset = sizeof(Header);
+		header.blobOffset = header.entriesOffset + (uint64_t)count * sizeof(Entry);
+
+		// lay out entry table up front, so the file is written sequentially
+		std::vector<Entry> entries(count);
+		uint64_t blobLength = 0;
+		for (int i = 0; i < count; i++) {
+			const wchar_t* name; size_t nameLen;
+			const wchar_t* desc; size_t descLen;
+			BOOL selected;
+			getOption(i, name, nameLen, desc, descLen, selected);
+
+			Entry& entry = entries[i];
+			entry = {};
+			entry.nameOffset = (uint32_t)blobLength;
+			entry.nameLength = (uint32_t)nameLen;
+			entry.descOffset = (uint32_t)(blobLength + nameLen);
+			entry.descLength = (uint32_t)descLen;
+			entry.nameWidth = (uint32_t)getDisplayWidth(name, nameLen);
+			entry.selected = selected ? 1 : 0;
+			blobLength += nameLen + descLen;
+		}
+		if (blobLength > UINT32_MAX) {
+			return FALSE;
 		}
-		std::wcout << std::endl;
+		header.fileSize = header.blobOffset + blobLength * sizeof(wchar_t);
 
-		if (m_instruction != NO_INSTRUCTION) {
-			renderInstruction();
-			std::wcout << L" | ";
+		HANDLE hFile = CreateFileW(path.c_str(), GENERIC_WRITE, 0, NULL,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (hFile == INVALID_HANDLE_VALUE) {
+			return FALSE;
 		}
-		if (m_B_USE_PAGING) {
-			renderPageInfo(m_currentPageIdx);
+		BOOL ok = writeAll(hFile, &header, sizeof(header)) &&
+			writeAll(hFile, entries.data(), (uint64_t)count * sizeof(Entry));
+
+		// stream string blob through a fixed size staging buffer
+		std::vector<wchar_t> staging;
+		staging.reserve(1 << 16);
+		for (int i = 0; ok && i < count; i++) {
+			const wchar_t* name; size_t nameLen;
+			const wchar_t* desc; size_t descLen;
+			BOOL selected;
+			getOption(i, name, nameLen, desc, descLen, selected);
+			if (staging.size() + nameLen + descLen > staging.capacity()) {
+				ok = writeAll(hFile, staging.data(), staging.size() * sizeof(wchar_t));
+				staging.clear();
+			}
+			if (nameLen + descLen > staging.capacity()) {
+				ok = ok && writeAll(hFile, name, nameLen * sizeof(wchar_t)) &&
+					writeAll(hFile, desc, descLen * sizeof(wchar_t));
+				continue;
+			}
+			staging.insert(staging.end(), name, name + nameLen);
+			staging.insert(staging.end(), desc, desc + descLen);
 		}
-		std::wcout << std::endl;
+		ok = ok && writeAll(hFile, staging.data(), staging.size() * sizeof(wchar_t));
 
-		// move console cursor to line of footer, and delete
-		moveConsoleCursorUp(
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size())
-			+ 1/*for spacing between options and description*/
-			+ 1/*for description*/
-			+ 2/*for footer itself*/);
+		CloseHandle(hFile);
+		if (!ok) {
+			DeleteFileW(path.c_str());
+		}
+		return ok;
 	}
+};
 
-	void renderTitle() override
-	{
-		std::wcout << m_title << std::endl;
-		for (int i = 0; i < m_title.length(); i++) {
-			std::wcout << L"-";
-		}
-		std::wcout << std::endl;
+/// <summary>
+/// option labels updated by other threads, while a menu is displayed.
+/// updates are only marked pending here (repeated updates of an option overwrite
+/// each other), and are applied by the menu's own thread, at a capped refresh rate.
+/// </summary>
+class LiveLabels
+{
+public:
+	LiveLabels() {
+		m_hUpdated = CreateEventW(NULL, FALSE/*auto-reset*/, FALSE, NULL);
+		setRefreshRate(DEFAULT_LIVE_REFRESH_RATE);
 	}
 
-	void renderOption(int optIdx) override
-	{
-		// move console cursor to line of selected option
-		moveConsoleCursorDown(optIdx % m_OPTIONS_PER_PAGE);
+	~LiveLabels() {
+		CloseHandle(m_hUpdated);
+	}
 
-		// display option
-		clearLine();
-		std::wcout << (m_menuCursorPos == optIdx % m_OPTIONS_PER_PAGE ? m_cursorStyle : L' ');
-		std::wcout << L" [" << (m_options[optIdx].IsSelected() ? L'*' : L' ') << L"] ";
-		std::wcout << truncateString(m_options[optIdx]._displayName, getConsoleLineSize() - 7);
-		std::wcout << std::endl;
+	LiveLabels(const LiveLabels&) = delete;
+	LiveLabels& operator=(const LiveLabels&) = delete;
 
-		// reset console cursor to initial position
-		moveConsoleCursorUp(optIdx % m_OPTIONS_PER_PAGE + 1/*account for lines rendered above*/);
+	void setRefreshRate(int refreshRate) {
+		m_intervalMs = refreshRate > 0 ? 1000 / refreshRate : 0;
 	}
 
-	BOOL isOptionInPage(int optIdx, int pageIdx) {
-		int startIdx = pageIdx * m_OPTIONS_PER_PAGE;
-		int endIdx = std::min(startIdx + m_OPTIONS_PER_PAGE, (int)m_options.size());
-
-		if (optIdx < endIdx && optIdx >= startIdx) {
-			return TRUE;
-		}
-		return FALSE;
+	// signaled on every update
+	HANDLE getUpdatedEvent() const {
+		return m_hUpdated;
 	}
 
-	int getNumOptionsInPage(int pageIdx) {
-		return std::min(m_OPTIONS_PER_PAGE, 
-			(int)m_options.size() - pageIdx * m_OPTIONS_PER_PAGE);
+	// called (on updating thread) along with signaling updated event
+	void setNotifier(const std::function<void()>& notifier)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_notifier = notifier;
 	}
 
-	void deletePage() {
-		int numOptsInPage;
-		if (m_B_USE_PAGING) {
-			 numOptsInPage = std::max(
-				getNumOptionsInPage(m_currentPageIdx),
-				m_OPTIONS_PER_PAGE
-				);
-		}
-		else {
-			numOptsInPage = getNumOptionsInPage(m_currentPageIdx);
+	void updateName(int optIdx, const std::wstring& name)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			PendingUpdate& update = m_pending[optIdx];
+			update.name = name;
+			update.bName = TRUE;
 		}
-		for (int i = 0; i < numOptsInPage; i++) {
-			clearLine();
-			moveConsoleCursorDown(1);
+		SetEvent(m_hUpdated);
+		notify();
+	}
+
+	void updateDescription(int optIdx, const std::wstring& description)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			PendingUpdate& update = m_pending[optIdx];
+			update.description = description;
+			update.bDescription = TRUE;
 		}
-		moveConsoleCursorUp(numOptsInPage);
+		SetEvent(m_hUpdated);
+		notify();
 	}
 
-	void renderPage(int pageIdx) {
+	// pending updates, and refresh interval elapsed since last applied
+	BOOL isDue()
+	{
+		if (GetTickCount64() < m_nextApplyMs) {
+			return FALSE;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return !m_pending.empty();
+	}
+
+	DWORD getMillisUntilDue() const
+	{
+		ULONGLONG nowMs = GetTickCount64();
+		return nowMs >= m_nextApplyMs ? 0 : (DWORD)(m_nextApplyMs - nowMs);
+	}
+
+	BOOL hasPending()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return !m_pending.empty();
+	}
+
+	// 'apply(optIdx, name, description)' gets NULL for a label not updated.
+	// (to be called by menu's thread only)
+	template <typename Apply>
+	void apply(Apply applyUpdate)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_applying.swap(m_pending);
+		}
+		for (auto& entry : m_applying) {
+			PendingUpdate& update = entry.second;
+			applyUpdate(entry.first, 
+				update.bName ? &update.name : NULL, 
+				update.bDescription ? &update.description : NULL);
+		}
+		m_applying.clear();
+		m_nextApplyMs = GetTickCount64() + m_intervalMs;
+	}
+
+private:
+	struct PendingUpdate
+	{
+		std::wstring name;
+		std::wstring description;
+		BOOL bName = FALSE;
+		BOOL bDescription = FALSE;
+	};
+
+	std::mutex m_mutex;
+	std::unordered_map<int, PendingUpdate> m_pending;	// also serves as dirty flags
+	std::unordered_map<int, PendingUpdate> m_applying;
+	HANDLE m_hUpdated;
+	std::function<void()> m_notifier;
+	ULONGLONG m_intervalMs = 0;
+	ULONGLONG m_nextApplyMs = 0;
+
+	void notify()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_notifier) {
+			m_notifier();
+		}
+	}
+};
+
+// colors of 'TextStyle' (basic 16 ANSI colors)
+enum TextColor : uint8_t
+{
+	COLOR_DEFAULT = 0,
+	COLOR_BLACK, COLOR_RED, COLOR_GREEN, COLOR_YELLOW,
+	COLOR_BLUE, COLOR_MAGENTA, COLOR_CYAN, COLOR_WHITE,
+	COLOR_BRIGHT_BLACK, COLOR_BRIGHT_RED, COLOR_BRIGHT_GREEN, COLOR_BRIGHT_YELLOW,
+	COLOR_BRIGHT_BLUE, COLOR_BRIGHT_MAGENTA, COLOR_BRIGHT_CYAN, COLOR_BRIGHT_WHITE
+};
+
+// attributes of 'TextStyle', may be combined
+enum TextAttribute : uint8_t
+{
+	ATTR_NONE		= 0,
+	ATTR_BOLD		= 1 << 0,
+	ATTR_DIM		= 1 << 1,
+	ATTR_UNDERLINE	= 1 << 2,
+	ATTR_REVERSE	= 1 << 3
+};
+
+/// <summary>
+/// compact style of a screen cell (3 bytes). default constructed style is plain text.
+/// </summary>
+struct TextStyle
+{
+	uint8_t fg;
+	uint8_t bg;
+	uint8_t attributes;
+
+	TextStyle(uint8_t fgColor = COLOR_DEFAULT, uint8_t bgColor = COLOR_DEFAULT, 
+		uint8_t attrs = ATTR_NONE)
+		: fg(fgColor), bg(bgColor), attributes(attrs) {}
+
+	BOOL isPlain() const {
+		return fg == COLOR_DEFAULT && bg == COLOR_DEFAULT && attributes == ATTR_NONE;
+	}
+
+	// 'style' drawn on top - its colors replace these (unless default), attributes add up
+	TextStyle overlay(const TextStyle& style) const
+	{
+		return TextStyle(style.fg != COLOR_DEFAULT ? style.fg : fg,
+			style.bg != COLOR_DEFAULT ? style.bg : bg, attributes | style.attributes);
+	}
+
+	bool operator==(const TextStyle& other) const {
+		return fg == other.fg && bg == other.bg && attributes == other.attributes;
+	}
+
+	bool operator!=(const TextStyle& other) const {
+		return !(*this == other);
+	}
+};
+
+// styled range of an option's name
+struct StyleSpan
+{
+	uint16_t start;
+	uint16_t length;
+	TextStyle style;
+};
+
+/// <summary>
+/// styles of menu parts. default constructed theme is monochrome.
+/// </summary>
+struct MenuTheme
+{
+	TextStyle title;
+	TextStyle hoveredOption;	// whole row under menu cursor
+	TextStyle selectionMark;	// mark of selected options
+	TextStyle match;			// substrings matching 'BasicMenu::highlightMatches()'
+	TextStyle description;
+	TextStyle footer;
+};
+
+/// <summary>
+/// terminal a menu is presented on. frames are written here, instead of straight to the
+/// process's console, so a single process can present menus on many terminals at once.
+/// (see 'MenuServer')
+/// </summary>
+class MenuEndpoint
+{
+public:
+	virtual ~MenuEndpoint() {}
+
+	virtual void write(const wchar_t* str, size_t len) = 0;
+	virtual void flush() = 0;
+
+	// columns per line, -1 if unknown
+	virtual int getLineSize() = 0;
+
+	// window row (0-based) of cursor, -1 if unknown
+	virtual int getCursorRow() = 0;
+
+	virtual void setCursorVisible(BOOL bVisible) = 0;
+
+	// whether a previous flush is still being written. frames are held back meanwhile,
+	// and the endpoint has the menu pump again once drained.
+	virtual BOOL isBusy() {
+		return FALSE;
+	}
+};
+
+/// <summary>
+/// the process's own console. (default endpoint of every menu)
+/// </summary>
+class ConsoleEndpoint : public MenuEndpoint
+{
+public:
+	static ConsoleEndpoint& instance()
+	{
+		static ConsoleEndpoint console;
+		return console;
+	}
+
+	void write(const wchar_t* str, size_t len) override {
+		std::wcout.write(str, len);
+	}
+
+	void flush() override
+	{
+		std::cout.flush();
+		std::wcout.flush();
+	}
+
+	int getLineSize() override
+	{
+		CONSOLE_SCREEN_BUFFER_INFO csbi;
+		if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
+			return -1;
+		}
+		return csbi.dwSize.X;
+	}
+
+	int getCursorRow() override
+	{
+		CONSOLE_SCREEN_BUFFER_INFO csbi;
+		if (!GetConsoleScreenBufferInfo(GetStdHandle(STD_OUTPUT_HANDLE), &csbi)) {
+			return -1;
+		}
+		return csbi.dwCursorPosition.Y - csbi.srWindow.Top;
+	}
+
+	void setCursorVisible(BOOL bVisible) override
+	{
+		HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
+		CONSOLE_CURSOR_INFO cursorInfo;
+		GetConsoleCursorInfo(hConsole, &cursorInfo);
+		cursorInfo.bVisible = bVisible;
+		SetConsoleCursorInfo(hConsole, &cursorInfo);
+	}
+};
+
+/// <summary>
+/// in-memory model of the console area occupied by a menu.
+/// frames are drawn into a back buffer, then 'flush()' diffs it against the previously
+/// flushed frame cell by cell, and emits only the characters and escape sequences needed
+/// to transform one into the other - using whichever cursor movement is the cheapest.
+/// a 2-column character (see 'getCharWidth()') occupies 2 cells, and is always written
+/// as a whole.
+/// </summary>
+class ScreenBuffer
+{
+public:
+	// discards contents of both buffers. next flush repaints all rows.
+	void resize(int width, int height)
+	{
+		m_width = std::max(width, 1);
+		m_height = std::max(height, 0);
+		m_back.assign((size_t)m_width * m_height, L' ');
+		m_front.assign((size_t)m_width * m_height, L' ');
+		m_backStyles.assign((size_t)m_width * m_height, TextStyle());
+		m_frontStyles.assign((size_t)m_width * m_height, TextStyle());
+		m_out.reserve((size_t)m_width * m_height * 2/*room for escape sequences*/);
+		m_bFrontValid = FALSE;
+	}
+
+	int getWidth() const {
+		return m_width;
+	}
+
+	int getHeight() const {
+		return m_height;
+	}
+
+	// where flushed frames are written
+	void setEndpoint(MenuEndpoint& endpoint) {
+		m_endpoint = &endpoint;
+	}
+
+	// console window row (0-based) of first row, enabling absolute cursor movement.
+	// -1 if unknown. expects the console cursor to be positioned at first row.
+	void setOrigin(int windowRow)
+	{
+		m_originRow = windowRow;
+		m_cursorRow = 0;
+		m_cursorCol = 0;
+	}
+
+	// next flush repaints all rows, regardless of previous frame
+	void invalidate() {
+		m_bFrontValid = FALSE;
+	}
+
+	void clearRow(int row) {
+		fill(row, 0, L' ', m_width);
+	}
+
+	// returns column just after written text. text is clipped to screen width.
+	int putText(int row, int col, const wchar_t* str, size_t len, 
+		const TextStyle& style = TextStyle())
+	{
+		wchar_t* cells = &m_back[(size_t)row * m_width];
+		TextStyle* styles = &m_backStyles[(size_t)row * m_width];
+		int startCol = col;
+		size_t i = 0;
+		while (i < len) {
+			BOOL bPair = isHighSurrogate(str[i]) && i + 1 < len && isLowSurrogate(str[i + 1]);
+			int charWidth = bPair ? 2 : getCharWidth(str[i]);
+			if (col + charWidth > m_width) {
+				break;
+			}
+			cells[col] = str[i];
+			styles[col] = style;
+			if (charWidth == 2) {
+				cells[col + 1] = bPair ? str[i + 1] : WIDE_CONTINUATION;
+				styles[col + 1] = style;
+			}
+			col += charWidth;
+			i += bPair ? 2 : 1;
+		}
+		blankSplitChars(row, startCol, col);
+		return col;
+	}
+
+	int putChar(int row, int col, wchar_t ch, const TextStyle& style = TextStyle()) {
+		return putText(row, col, &ch, 1, style);
+	}
+
+	// replaces whole row, padding with blanks
+	void putRow(int row, const wchar_t* str, size_t len)
+	{
+		int col = putText(row, 0, str, len);
+		fill(row, col, L' ', m_width - col);
+	}
+
+	// 'ch' is expected to take a single column
+	int fill(int row, int col, wchar_t ch, int count, const TextStyle& style = TextStyle())
+	{
+		count = std::min(count, m_width - col);
+		if (count > 0) {
+			size_t offset = (size_t)row * m_width + col;
+			std::fill_n(&m_back[offset], count, ch);
+			std::fill_n(&m_backStyles[offset], count, style);
+			blankSplitChars(row, col, col + count);
+		}
+		return col + std::max(count, 0);
+	}
+
+	// draws 'style' on top of written cells. (see 'TextStyle::overlay()')
+	void applyStyle(int row, int col, int count, const TextStyle& style)
+	{
+		count = std::min(count, m_width - col);
+		TextStyle* styles = &m_backStyles[(size_t)row * m_width];
+		for (int i = std::max(col, 0); i < col + count; i++) {
+			styles[i] = styles[i].overlay(style);
+		}
+	}
+
+	// writes difference between back buffer and previous frame to console
+	void flush()
+	{
+		syncOrigin();
+		m_out.clear();
+		for (int row = 0; row < m_height; row++) {
+			size_t offset = (size_t)row * m_width;
+			wchar_t* back = &m_back[offset];
+			wchar_t* front = &m_front[offset];
+			TextStyle* backStyles = &m_backStyles[offset];
+			TextStyle* frontStyles = &m_frontStyles[offset];
+			if (!m_bFrontValid) {
+				appendMove(row, 0);
+				appendErase(L"\033[2K");
+				std::fill_n(front, m_width, L' ');
+				std::fill_n(frontStyles, m_width, TextStyle());
+			}
+
+			// style changes only at boundaries of equally styled runs
+			int backEnd = getRowEnd(back, backStyles);
+			for (int col = 0; col < backEnd; ) {
+				int charWidth = (isLeadCell(back[col]) && col + 1 < m_width && 
+					isTrailCell(back[col + 1])) ? 2 : 1;
+				BOOL bChanged = FALSE;
+				for (int i = col; i < col + charWidth; i++) {
+					bChanged = bChanged || back[i] != front[i] || backStyles[i] != frontStyles[i];
+				}
+				if (bChanged) {
+					appendMove(row, col);
+					appendStyle(backStyles[col]);
+					m_out.push_back(back[col]);
+					if (charWidth == 2 && back[col + 1] != WIDE_CONTINUATION) {
+						m_out.push_back(back[col + 1]); // low surrogate
+					}
+					std::copy(back + col, back + col + charWidth, front + col);
+					std::copy(backStyles + col, backStyles + col + charWidth, frontStyles + col);
+					m_cursorCol += charWidth;
+
+					// console blanks the rest of a 2-column character overwritten in part
+					if (col + charWidth < m_width && isTrailCell(front[col + charWidth])) {
+						front[col + charWidth] = DAMAGED_CELL;
+					}
+				}
+				col += charWidth;
+			}
+
+			// clear leftovers of previous frame -
+			// erase to end of line, or overwrite with spaces, whichever is cheaper
+			int frontEnd = getRowEnd(front, frontStyles);
+			if (frontEnd > backEnd) {
+				int col = backEnd;
+				while (isBlank(front[col], frontStyles[col])) {
+					col++;
+				}
+				int numSpaces = 0;
+				for (int i = col; i < frontEnd; i++) {
+					numSpaces += !isBlank(front[i], frontStyles[i]);
+				}
+				if (numSpaces > 3/*EL*/) {
+					appendMove(row, col);
+					appendErase(L"\033[K");
+				}
+				else {
+					for (int i = col; i < frontEnd; i++) {
+						if (!isBlank(front[i], frontStyles[i])) {
+							appendMove(row, i);
+							appendStyle(TextStyle());
+							m_out.push_back(L' ');
+							m_cursorCol++;
+						}
+					}
+				}
+				std::fill(front + col, front + frontEnd, L' ');
+				std::fill(frontStyles + col, frontStyles + frontEnd, TextStyle());
+			}
+		}
+		m_bFrontValid = TRUE;
+
+		// leave console as found
+		appendStyle(TextStyle());
+
+		if (!m_out.empty()) {
+			m_endpoint->write(m_out.data(), m_out.size());
+		}
+	}
+
+	// moves console cursor, relative to first row. rows past the last one are allowed.
+	void moveCursor(int row, int col)
+	{
+		m_out.clear();
+		appendMove(row, col);
+		m_endpoint->write(m_out.data(), m_out.size());
+	}
+
+	// SGR parameters changing 'from' into 'to', without resetting. returns count.
+	static int getStyleParams(const TextStyle& from, const TextStyle& to, int* params)
+	{
+		int count = 0;
+		uint8_t removed = from.attributes & ~to.attributes;
+		uint8_t added = to.attributes & ~from.attributes;
+		if (removed & (ATTR_BOLD | ATTR_DIM)) {
+			params[count++] = 22; // turns off both
+			added |= to.attributes & (ATTR_BOLD | ATTR_DIM);
+		}
+		if (removed & ATTR_UNDERLINE) {
+			params[count++] = 24;
+		}
+		if (removed & ATTR_REVERSE) {
+			params[count++] = 27;
+		}
+		if (added & ATTR_BOLD) {
+			params[count++] = 1;
+		}
+		if (added & ATTR_DIM) {
+			params[count++] = 2;
+		}
+		if (added & ATTR_UNDERLINE) {
+			params[count++] = 4;
+		}
+		if (added & ATTR_REVERSE) {
+			params[count++] = 7;
+		}
+		if (from.fg != to.fg) {
+			params[count++] = to.fg == COLOR_DEFAULT ? 39 : 
+				(to.fg <= COLOR_WHITE ? 30 + to.fg - COLOR_BLACK : 90 + to.fg - COLOR_BRIGHT_BLACK);
+		}
+		if (from.bg != to.bg) {
+			params[count++] = to.bg == COLOR_DEFAULT ? 49 : 
+				(to.bg <= COLOR_WHITE ? 40 + to.bg - COLOR_BLACK : 100 + to.bg - COLOR_BRIGHT_BLACK);
+		}
+		return count;
+	}
+
+private:
+	MenuEndpoint* m_endpoint = &ConsoleEndpoint::instance();
+	int m_width = 1;
+	int m_height = 0;
+	std::vector<wchar_t> m_back;
+	std::vector<wchar_t> m_front;	// as currently displayed
+	std::vector<TextStyle> m_backStyles;
+	std::vector<TextStyle> m_frontStyles;
+	BOOL m_bFrontValid = FALSE;
+	int m_originRow = -1;
+	int m_cursorRow = 0;
+	int m_cursorCol = 0;
+	TextStyle m_style;				// console's current style
+	std::wstring m_out;
+
+	// second cell of a wide character
+	static const wchar_t WIDE_CONTINUATION = L'\0';
+	// cell of previous frame whose content on console is unknown, forcing a re-write
+	static const wchar_t DAMAGED_CELL = (wchar_t)0xFFFF;
+
+	// console window may have been scrolled or resized since origin was set.
+	// re-derived from where the cursor actually is - or, if that can't be told, 
+	// only relative movement is used.
+	void syncOrigin()
+	{
+		int cursorRow = m_endpoint->getCursorRow();
+		m_originRow = cursorRow >= m_cursorRow ? cursorRow - m_cursorRow : -1;
+	}
+
+	static BOOL isBlank(wchar_t ch, const TextStyle& style) {
+		return ch == L' ' && style.isPlain();
+	}
+
+	// first / second cell of a 2-column character
+	static BOOL isLeadCell(wchar_t ch) {
+		return isHighSurrogate(ch) || getCharWidth(ch) == 2;
+	}
+
+	static BOOL isTrailCell(wchar_t ch) {
+		return ch == WIDE_CONTINUATION || isLowSurrogate(ch);
+	}
+
+	// cells [col, end) were just written - blanks what is left of 2-column characters
+	// straddling either edge, since those can't be displayed in part
+	void blankSplitChars(int row, int col, int end)
+	{
+		if (col >= end) {
+			return;
+		}
+		wchar_t* cells = &m_back[(size_t)row * m_width];
+		if (col > 0 && isLeadCell(cells[col - 1])) {
+			cells[col - 1] = L' ';
+		}
+		if (end < m_width && isTrailCell(cells[end])) {
+			cells[end] = L' ';
+		}
+	}
+
+	int getRowEnd(const wchar_t* row, const TextStyle* styles) const
+	{
+		int end = m_width;
+		while (end > 0 && isBlank(row[end - 1], styles[end - 1])) {
+			end--;
+		}
+		return end;
+	}
+
+	// erased cells take the current background color
+	void appendErase(const wchar_t* sequence)
+	{
+		if (m_style.bg != COLOR_DEFAULT || (m_style.attributes & ATTR_REVERSE)) {
+			appendStyle(TextStyle());
+		}
+		m_out.append(sequence);
+	}
+
+	static int getParamsCost(const int* params, int count)
+	{
+		int cost = 0;
+		for (int i = 0; i < count; i++) {
+			cost += numDigits(params[i]) + (i > 0 ? 1 : 0);
+		}
+		return cost;
+	}
+
+	// switches console to 'style' - by changed attributes only, 
+	// or by reset & all attributes, whichever is cheaper
+	void appendStyle(const TextStyle& style)
+	{
+		if (style == m_style) {
+			return;
+		}
+		int changeParams[8];
+		int resetParams[8];
+		int numChangeParams = getStyleParams(m_style, style, changeParams);
+		int numResetParams = getStyleParams(TextStyle(), style, resetParams);
+		int resetCost = numResetParams == 0 ? 0 : 1 + getParamsCost(resetParams, numResetParams);
+
+		m_out.append(L"\033[");
+		if (resetCost <= getParamsCost(changeParams, numChangeParams)) {
+			// 'ESC [ m' resets, reset of 'ESC [ ; ...' is implied
+			for (int i = 0; i < numResetParams; i++) {
+				m_out.push_back(L';');
+				appendNumber(resetParams[i]);
+			}
+		}
+		else {
+			for (int i = 0; i < numChangeParams; i++) {
+				if (i > 0) {
+					m_out.push_back(L';');
+				}
+				appendNumber(changeParams[i]);
+			}
+		}
+		m_out.push_back(L'm');
+		m_style = style;
+	}
+
+	static int numDigits(int n)
+	{
+		int digits = 1;
+		while (n >= 10) {
+			n /= 10;
+			digits++;
+		}
+		return digits;
+	}
+
+	// length of 'ESC [ n X', where n=1 is implied
+	static int relativeMoveCost(int n) {
+		return n == 0 ? 0 : (n == 1 ? 3 : 3 + numDigits(n));
+	}
+
+	void appendNumber(int n)
+	{
+		wchar_t digits[12];
+		int numDigitsWritten = 0;
+		do {
+			digits[numDigitsWritten++] = L'0' + n % 10;
+			n /= 10;
+		} while (n > 0);
+		while (numDigitsWritten > 0) {
+			m_out.push_back(digits[--numDigitsWritten]);
+		}
+	}
+
+	// 'ESC [ n X', where n=1 is implied
+	void appendSequence(int n, wchar_t final)
+	{
+		m_out.append(L"\033[");
+		if (n != 1) {
+			appendNumber(n);
+		}
+		m_out.push_back(final);
+	}
+
+	// whether displayed cells can be re-written, to move the console cursor over them - 
+	// all in 'style', known, and not splitting 2-column characters
+	BOOL isRunRewritable(int row, int col, int count, const TextStyle& style) const
+	{
+		const wchar_t* cells = &m_front[(size_t)row * m_width];
+		const TextStyle* styles = &m_frontStyles[(size_t)row * m_width];
+		if (isTrailCell(cells[col]) || (col + count < m_width && isTrailCell(cells[col + count]))) {
+			return FALSE;
+		}
+		for (int i = col; i < col + count; i++) {
+			if (styles[i] != style || cells[i] == DAMAGED_CELL) {
+				return FALSE;
+			}
+		}
+		return TRUE;
+	}
+
+	void appendMove(int row, int col)
+	{
+		int dRow = row - m_cursorRow;
+		int dCol = col - m_cursorCol;
+		if (dRow == 0 && dCol == 0) {
+			return;
+		}
+
+		// horizontal candidates: relative / carriage return + relative /
+		// re-writing skipped (unchanged) cells / absolute column
+		int relativeCost = relativeMoveCost(std::abs(dCol));
+		int carriageReturnCost = 1 + relativeMoveCost(col);
+		int rewriteCost = (dRow == 0 && dCol > 0 && row < m_height && 
+			isRunRewritable(row, m_cursorCol, dCol, m_style)) ? dCol : INT_MAX;
+		int columnCost = 3 + (col == 0 ? 0 : numDigits(col + 1));
+		int horizontalCost = std::min({ relativeCost, carriageReturnCost, rewriteCost, columnCost });
+
+		// absolute candidate: 'ESC [ row ; col H'
+		int absoluteCost = INT_MAX;
+		if (m_originRow >= 0) {
+			absoluteCost = 3 + numDigits(m_originRow + row + 1) + 
+				(col == 0 ? 0 : 1 + numDigits(col + 1));
+		}
+
+		if (absoluteCost < relativeMoveCost(std::abs(dRow)) + horizontalCost) {
+			m_out.append(L"\033[");
+			appendNumber(m_originRow + row + 1);
+			if (col != 0) {
+				m_out.push_back(L';');
+				appendNumber(col + 1);
+			}
+			m_out.push_back(L'H');
+		}
+		else {
+			if (dRow != 0) {
+				appendSequence(std::abs(dRow), dRow < 0 ? L'A' : L'B');
+			}
+			if (horizontalCost == relativeCost) {
+				if (dCol != 0) {
+					appendSequence(std::abs(dCol), dCol < 0 ? L'D' : L'C');
+				}
+			}
+			else if (horizontalCost == carriageReturnCost) {
+				m_out.push_back(L'\r');
+				if (col != 0) {
+					appendSequence(col, L'C');
+				}
+			}
+			else if (horizontalCost == rewriteCost) {
+				const wchar_t* cells = &m_front[(size_t)row * m_width + m_cursorCol];
+				for (int i = 0; i < dCol; i++) {
+					if (cells[i] != WIDE_CONTINUATION) {
+						m_out.push_back(cells[i]);
+					}
+				}
+			}
+			else {
+				appendSequence(col + 1, L'G');
+			}
+		}
+		m_cursorRow = row;
+		m_cursorCol = col;
+	}
+};
+
+/// <summary>
+/// most basic menu class
+/// </summary>
+class BasicMenu 
+{
+public:
+
+	virtual void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") {
+		m_options.push_back({ optDisplayName, optDescription });
+	}
+
+	// description is computed by 'descriptionProvider' only once the option is hovered,
+	// and is not part of the returned 'MenuState'.
+	virtual void addOption(const std::wstring& optDisplayName, const DescriptionProvider& descriptionProvider) {
+		m_descriptionProviders[(int)m_options.size()] = descriptionProvider;
+		m_options.push_back({ optDisplayName, L"" });
+	}
+
+	// constructs option in place, strings are moved in
+	void emplaceOption(std::wstring&& optDisplayName, std::wstring&& optDescription = std::wstring(),
+		BOOL isSelectedByDefault = FALSE)
+	{
+		insertOption(std::move(optDisplayName), std::move(optDescription), isSelectedByDefault);
+		onOptionsAdded();
+	}
+
+	// adds a range of 'OptionEntry', layout is recomputed once at the end.
+	// entries are copied, unless passed through 'std::make_move_iterator()'.
+	template <typename Iterator>
+	void addOptions(Iterator first, Iterator last)
+	{
+		reserveFor(first, last, typename std::iterator_traits<Iterator>::iterator_category());
+		for (; first != last; ++first) {
+			OptionEntry entry(*first);
+			insertOption(std::move(entry.displayName), std::move(entry.description), 
+				entry.isSelectedByDefault);
+		}
+		onOptionsAdded();
+	}
+
+	void addOptions(std::vector<OptionEntry>&& entries) {
+		addOptions(std::make_move_iterator(entries.begin()), std::make_move_iterator(entries.end()));
+		entries.clear();
+	}
+
+	// STYLING
+	// (plain text unless set. tree menus key options by node id, table menus by row id)
+
+	void setTheme(const MenuTheme& theme)
+	{
+		m_theme = theme;
+		invalidateLayout();
+	}
+
+	// style of whole option row, e.g. dimmed for unavailable options
+	void setOptionStyle(int optIdx, const TextStyle& style)
+	{
+		m_optionStyles[optIdx] = style;
+		onOptionStyled(optIdx);
+	}
+
+	// styles part of option's name
+	void addOptionSpan(int optIdx, size_t start, size_t length, const TextStyle& style)
+	{
+		if (start > UINT16_MAX) {
+			return;
+		}
+		m_optionSpans[optIdx].push_back({ (uint16_t)start, (uint16_t)std::min(length, (size_t)UINT16_MAX), style });
+		onOptionStyled(optIdx);
+	}
+
+	void clearOptionSpans(int optIdx)
+	{
+		m_optionSpans.erase(optIdx);
+		onOptionStyled(optIdx);
+	}
+
+	// emphasizes substrings of option names matching 'query' (case-insensitive),
+	// in theme's 'match' style. empty query clears.
+	void highlightMatches(const std::wstring& query)
+	{
+		m_matchQuery = query;
+		invalidateLayout();
+	}
+
+	// max amount of lazily computed descriptions kept at once
+	void setDescriptionCacheSize(size_t cacheSize) {
+		m_descriptionCache.setCapacity(cacheSize);
+	}
+
+	// frames exceeding this rate are dropped, only the newest state is painted.
+	// (0 paints every frame)
+	void setMaxFrameRate(int maxFrameRate) {
+		m_framePacer.setMaxFrameRate(maxFrameRate);
+	}
+
+	// LIVE UPDATES
+	// (safe to call from any thread, also while the menu is executing.
+	// FALSE for menus keeping options of their own, like tree & table menus)
+
+	BOOL updateOption(int optIdx, const std::wstring& optDisplayName)
+	{
+		if (!hasOptionList()) {
+			return FALSE;
+		}
+		m_liveLabels.updateName(optIdx, optDisplayName);
+		return TRUE;
+	}
+
+	BOOL updateOptionDescription(int optIdx, const std::wstring& optDescription)
+	{
+		if (!hasOptionList()) {
+			return FALSE;
+		}
+		m_liveLabels.updateDescription(optIdx, optDescription);
+		return TRUE;
+	}
+
+	// max times per second live updates are repainted
+	void setLiveRefreshRate(int refreshRate) {
+		m_liveLabels.setRefreshRate(refreshRate);
+	}
+
+	// present options of a precompiled catalog, instead of added ones.
+	// the catalog must remain open for as long as the menu is used.
+	// FALSE for menus keeping options of their own, like tree & table menus.
+	virtual BOOL loadCatalog(OptionCatalog& catalog)
+	{
+		if (!hasOptionList()) {
+			return FALSE;
+		}
+		m_catalog = &catalog;
+		return TRUE;
+	}
+
+	virtual void execute() = 0;
+
+	virtual MenuState getState() {
+		if (m_catalog == NULL && m_liveNames.empty() && m_liveDescriptions.empty()) {
+			return MenuState(m_options);
+		}
+
+		// materialize catalog options, or options with live labels
+		std::vector<Option> options;
+		options.reserve(getOptionCount());
+		for (int i = 0; i < getOptionCount(); i++) {
+			size_t nameLen, descLen = 0;
+			const wchar_t* name = getOptionName(i, nameLen);
+			const wchar_t* desc = L"";
+			if (!isDescriptionLazy(i)) {
+				desc = getOptionDescription(i, descLen);
+			}
+			options.push_back({ std::wstring(name, nameLen), std::wstring(desc, descLen) });
+			options.back()._selected = isOptionSelected(i);
+		}
+		return MenuState(options);
+	}
+
+	// grant catalog writer access to option accessors
+	friend class OptionCatalog;
+
+	// grant server access to endpoint & frame pumping
+	friend class MenuServer;
+
+private:
+protected:
+	BasicMenu(const std::wstring& menuTitle) : m_title(menuTitle), m_options({}) {}
+	~BasicMenu() {};
+
+	std::wstring m_title;
+	std::vector<Option> m_options;
+	MenuEndpoint* m_endpoint = &ConsoleEndpoint::instance();
+	OptionCatalog* m_catalog = NULL;
+
+	// lazy descriptions, by option index. (declared before the cache, whose worker 
+	// calls them - so they are destroyed after it)
+	std::unordered_map<int, DescriptionProvider> m_descriptionProviders;
+	DescriptionCache m_descriptionCache;
+	std::wstring m_descriptionScratch;
+
+	// styling
+	MenuTheme m_theme;
+	std::unordered_map<int, TextStyle> m_optionStyles;
+	std::unordered_map<int, std::vector<StyleSpan>> m_optionSpans;
+	std::wstring m_matchQuery;
+
+	// labels updated while displayed, override original ones
+	LiveLabels m_liveLabels;
+	std::unordered_map<int, std::wstring> m_liveNames;
+	std::unordered_map<int, std::wstring> m_liveDescriptions;
+	int m_menuCursorPos = 0;
+
+	// parts of the menu invalidated since last painted frame
+	FramePacer m_framePacer;
+	std::vector<int> m_dirtyOptions;
+	BOOL m_bDescriptionDirty = FALSE;
+	BOOL m_bLayoutDirty = FALSE;
+
+	// OPTION ACCESSORS
+	// (resolve either added options or a loaded catalog)
+
+	// whether options are the ones resolved below. FALSE for menus storing options 
+	// of their own, which report them through 'getState()' instead.
+	virtual BOOL hasOptionList() const {
+		return TRUE;
+	}
+
+	virtual int getOptionCount() const {
+		return m_catalog ? m_catalog->size() : (int)m_options.size();
+	}
+
+	const wchar_t* getOptionName(int optIdx, size_t& len) const {
+		if (!m_liveNames.empty()) {
+			auto it = m_liveNames.find(optIdx);
+			if (it != m_liveNames.end()) {
+				len = it->second.size();
+				return it->second.c_str();
+			}
+		}
+		if (m_catalog) {
+			return m_catalog->getName(optIdx, len);
+		}
+		len = m_options[optIdx]._displayName.size();
+		return m_options[optIdx]._displayName.c_str();
+	}
+
+	// NULL unless description is computed only once hovered (see 'addOption()')
+	const DescriptionProvider* getDescriptionProvider(int optIdx) const {
+		if (m_catalog || m_descriptionProviders.empty()) {
+			return NULL;
+		}
+		auto it = m_descriptionProviders.find(optIdx);
+		return it == m_descriptionProviders.end() ? NULL : &it->second;
+	}
+
+	BOOL isDescriptionLazy(int optIdx) const {
+		return getDescriptionProvider(optIdx) != NULL &&
+			m_liveDescriptions.find(optIdx) == m_liveDescriptions.end();
+	}
+
+	// lazy descriptions resolve to 'PENDING_DESCRIPTION' until computed
+	const wchar_t* getOptionDescription(int optIdx, size_t& len) {
+		if (!m_liveDescriptions.empty()) {
+			auto it = m_liveDescriptions.find(optIdx);
+			if (it != m_liveDescriptions.end()) {
+				len = it->second.size();
+				return it->second.c_str();
+			}
+		}
+		if (m_catalog) {
+			return m_catalog->getDescription(optIdx, len);
+		}
+		if (getDescriptionProvider(optIdx)) {
+			if (!m_descriptionCache.lookup(optIdx, m_descriptionScratch)) {
+				m_descriptionScratch.assign(PENDING_DESCRIPTION);
+			}
+			len = m_descriptionScratch.size();
+			return m_descriptionScratch.c_str();
+		}
+		len = m_options[optIdx]._description.size();
+		return m_options[optIdx]._description.c_str();
+	}
+
+	// queue lazy description of hovered option, and of its neighbours
+	void requestDescription(int optIdx)
+	{
+		if (m_catalog || m_descriptionProviders.empty()) {
+			return;
+		}
+		DescriptionCache::Request requests[DescriptionCache::MAX_REQUESTS];
+		int numRequests = 0;
+		for (int idx : { optIdx, optIdx - 1, optIdx + 1 }) {
+			const DescriptionProvider* provider = getDescriptionProvider(idx);
+			if (provider) {
+				requests[numRequests++] = { idx, provider };
+			}
+		}
+		m_descriptionCache.request(optIdx, requests, numRequests);
+	}
+
+	// blocks until a key is pressed. meanwhile, paints frames dropped by the pacer,
+	// repaints the description of hovered option once it is computed,
+	// and repaints options updated by other threads.
+	// text input keeps keys typed ahead, and reads them as wide characters.
+	int readKey(BOOL bTextInput = FALSE)
+	{
+		if (!bTextInput) {
+			clearInputBuffer();
+		}
+		HANDLE waitHandles[3] = { 
+			GetStdHandle(STD_INPUT_HANDLE), 
+			m_descriptionCache.getReadyEvent(),
+			m_liveLabels.getUpdatedEvent()
+		};
+		DWORD timeout = pumpFrame();
+		while (!_kbhit()) {
+			DWORD waitResult = WaitForMultipleObjects(3, waitHandles, FALSE, timeout);
+			if (waitResult == WAIT_OBJECT_0) {
+				discardNonKeyInput(waitHandles[0]);
+			}
+			else if (waitResult == WAIT_OBJECT_0 + 1) {
+				invalidateDescription();
+			}
+			timeout = pumpFrame();
+		}
+		return bTextInput ? _getwch() : _getch();
+	}
+
+	// drops input records that '_kbhit()' doesn't report (key releases, mouse, focus, 
+	// resize...), which would otherwise keep the input handle signaled.
+	// records arriving meanwhile are kept, so no keystroke is lost.
+	static void discardNonKeyInput(HANDLE hInput)
+	{
+		DWORD numRecords = 0;
+		if (!GetNumberOfConsoleInputEvents(hInput, &numRecords) || numRecords == 0 || _kbhit()) {
+			return;
+		}
+		INPUT_RECORD records[16];
+		while (numRecords > 0) {
+			DWORD numRead = 0;
+			if (!ReadConsoleInputW(hInput, records, std::min<DWORD>(numRecords, 16), &numRead) || 
+				numRead == 0
+			) {
+				return;
+			}
+			numRecords -= numRead;
+		}
+	}
+
+	// applies due live updates and paints a dropped frame, if due by now.
+	// returns milliseconds until there is something to paint again (INFINITE if nothing).
+	DWORD pumpFrame()
+	{
+		if (m_liveLabels.isDue()) {
+			applyLiveUpdates();
+		}
+		presentFrame();
+		DWORD timeout = isFramePending() && !m_endpoint->isBusy() ? 
+			m_framePacer.getMillisUntilDue() : INFINITE;
+		if (m_liveLabels.hasPending()) {
+			timeout = std::min(timeout, m_liveLabels.getMillisUntilDue());
+		}
+		return timeout;
+	}
+
+	// called whenever the menu has something new to paint, from any thread.
+	// (lazy description computed, or label updated)
+	void setWakeHandler(const std::function<void()>& wakeHandler)
+	{
+		m_descriptionCache.setNotifier(wakeHandler);
+		m_liveLabels.setNotifier(wakeHandler);
+	}
+
+	virtual void setEndpoint(MenuEndpoint& endpoint) {
+		m_endpoint = &endpoint;
+	}
+
+	// whether option is currently on screen
+	virtual BOOL isOptionDisplayed(int optIdx) {
+		return TRUE;
+	}
+
+	// display name of option changed
+	virtual void onOptionRelabeled(int optIdx) {}
+
+	// style or spans of option changed
+	virtual void onOptionStyled(int optIdx) {
+		invalidateOption(optIdx);
+	}
+
+	// OPTION INSERTION
+	// ('emplaceOption()' / 'addOptions()' insert each option, then notify once)
+
+	virtual void insertOption(std::wstring&& optDisplayName, std::wstring&& optDescription,
+		BOOL isSelectedByDefault)
+	{
+		m_options.emplace_back(Option::ConstructionKey(), 
+			std::move(optDisplayName), std::move(optDescription), isSelectedByDefault);
+	}
+
+	virtual void reserveOptions(size_t count) {
+		m_options.reserve(m_options.size() + count);
+	}
+
+	virtual void onOptionsAdded() {}
+
+	template <typename Iterator>
+	void reserveFor(Iterator first, Iterator last, std::forward_iterator_tag) {
+		reserveOptions((size_t)std::distance(first, last));
+	}
+
+	// single pass ranges can't be measured
+	template <typename Iterator>
+	void reserveFor(Iterator first, Iterator last, std::input_iterator_tag) {}
+
+	// takes over pending live updates, invalidating only displayed options
+	void applyLiveUpdates()
+	{
+		m_liveLabels.apply([this](int optIdx, std::wstring* name, std::wstring* description) {
+			if (optIdx < 0 || optIdx >= getOptionCount()) {
+				return;
+			}
+			if (name) {
+				m_liveNames[optIdx].swap(*name);
+				onOptionRelabeled(optIdx);
+				if (isOptionDisplayed(optIdx)) {
+					invalidateOption(optIdx);
+				}
+			}
+			if (description) {
+				m_liveDescriptions[optIdx].swap(*description);
+				if (optIdx == getHoveredOptionIdx()) {
+					invalidateDescription();
+				}
+			}
+		});
+	}
+
+	// FRAME CONTROL
+	// (state changes only invalidate parts of the menu, painted later by 'presentFrame()')
+
+	virtual int getHoveredOptionIdx() {
+		return m_menuCursorPos;
+	}
+
+	void invalidateOption(int optIdx)
+	{
+		if (m_bLayoutDirty) {
+			return;
+		}
+		for (int dirtyIdx : m_dirtyOptions) {
+			if (dirtyIdx == optIdx) {
+				return;
+			}
+		}
+		m_dirtyOptions.push_back(optIdx);
+	}
+
+	void invalidateDescription() {
+		m_bDescriptionDirty = TRUE;
+	}
+
+	// whole menu is repainted, along with any invalidated option
+	void invalidateLayout() {
+		m_bLayoutDirty = TRUE;
+		m_dirtyOptions.clear();
+	}
+
+	BOOL isFramePending() const {
+		return m_bLayoutDirty || m_bDescriptionDirty || !m_dirtyOptions.empty();
+	}
+
+	// paints invalidated parts, unless the pacer says it is too early.
+	// a dropped frame is painted later by 'readKey()', reflecting the newest state.
+	void presentFrame(BOOL bForce = FALSE)
+	{
+		if (!isFramePending() || (!bForce && (m_endpoint->isBusy() || !m_framePacer.isFrameDue()))) {
+			return;
+		}
+		m_framePacer.beginFrame();
+		paintFrame();
+		m_endpoint->flush();
+		m_framePacer.endFrame();
+
+		m_dirtyOptions.clear();
+		m_bDescriptionDirty = FALSE;
+		m_bLayoutDirty = FALSE;
+	}
+
+	virtual void paintFrame()
+	{
+		if (m_bLayoutDirty) {
+			for (int optIdx = 0; optIdx < getOptionCount(); optIdx++) {
+				renderOption(optIdx);
+			}
+		}
+		else {
+			for (int optIdx : m_dirtyOptions) {
+				renderOption(optIdx);
+			}
+		}
+		if (m_bDescriptionDirty) {
+			renderDescription(getHoveredOptionIdx());
+		}
+	}
+
+	// -1 if not known up front (see 'getTruncation()')
+	int getOptionNameWidth(int optIdx) const {
+		if (m_catalog && m_liveNames.find(optIdx) == m_liveNames.end()) {
+			return m_catalog->getNameWidth(optIdx);
+		}
+		return -1;
+	}
+
+	BOOL isOptionSelected(int optIdx) const {
+		return m_catalog ? m_catalog->isSelected(optIdx) : m_options[optIdx].IsSelected();
+	}
+
+	virtual void renderTitle() = 0;
+	virtual void renderOption(int optIdx) = 0;
+	virtual void renderDescription(int optIdx) = 0;
+	virtual void deleteDescription() = 0;
+	// scrolls console down enough line so menu is not torn apart
+	virtual void scrollConsole() = 0;
+	
+	// how a string is shortened to 'maxSize' columns: its first 'prefixLen' characters, 
+	// followed - when 'bMarked' - by '~' and its last 'suffixLen' characters
+	struct Truncation
+	{
+		size_t prefixLen = 0;
+		size_t suffixLen = 0;
+		BOOL bMarked = FALSE;
+		int width = 0;				// columns of truncated string
+	};
+
+	// 'width' is the display width of 'str', when known - sparing a scan of strings that fit
+	static Truncation getTruncation(const wchar_t* str, size_t len, int maxSize, int width = -1)
+	{
+		Truncation truncation;
+		if (width == -1) {
+			// no character is narrower than a column
+			width = len > (size_t)std::max(maxSize, 0) ? INT_MAX : getDisplayWidth(str, len);
+		}
+		if (width <= maxSize) {
+			truncation.prefixLen = len;
+			truncation.width = width;
+			return truncation;
+		}
+		// suffix of TRUNC_CHARS characters, not starting mid surrogate pair
+		size_t suffixLen = std::min((size_t)TRUNC_CHARS, len);
+		if (suffixLen < len && isLowSurrogate(str[len - suffixLen])) {
+			suffixLen++;
+		}
+		int suffixWidth = getDisplayWidth(str + len - suffixLen, suffixLen);
+		if (maxSize - suffixWidth <= 0) {
+			truncation.prefixLen = getFittingLength(str, len, std::max(maxSize, 0), truncation.width);
+			return truncation;
+		}
+		int prefixWidth;
+		truncation.prefixLen = getFittingLength(str, len, maxSize - suffixWidth, prefixWidth);
+		truncation.suffixLen = suffixLen;
+		truncation.bMarked = TRUE;
+		truncation.width = prefixWidth + 1/*truncation mark*/ + suffixWidth;
+		return truncation;
+	}
+
+	std::wstring truncateString(const std::wstring& str, int maxSize)
+	{
+		std::wstring truncatedStr;
+		appendTruncated(truncatedStr, str.c_str(), str.size(), maxSize);
+		return truncatedStr;
+	}
+
+	// same as 'truncateString()', appending to 'out'
+	static void appendTruncated(std::wstring& out, const wchar_t* str, size_t len, 
+		const Truncation& truncation)
+	{
+		out.append(str, truncation.prefixLen);
+		if (truncation.bMarked) {
+			out.push_back(L'~');
+			out.append(str + len - truncation.suffixLen, truncation.suffixLen);
+		}
+	}
+
+	static void appendTruncated(std::wstring& out, const wchar_t* str, size_t len, int maxSize) {
+		appendTruncated(out, str, len, getTruncation(str, len, maxSize));
+	}
+
+	void hideConsoleCursor() {
+		m_endpoint->setCursorVisible(FALSE);
+	}
+
+	void showConsoleCursor() {
+		m_endpoint->setCursorVisible(TRUE);
+	}
+
+	int getConsoleLineSize() {
+		return m_endpoint->getLineSize();
+	}
+
+	// discard any unread input
+	void clearInputBuffer() {
+		HANDLE hInput = GetStdHandle(STD_INPUT_HANDLE);
+		FlushConsoleInputBuffer(hInput);
+	}
+
+	// writes straight to menu's endpoint
+	void writeText(const wchar_t* str) {
+		m_endpoint->write(str, wcslen(str));
+	}
+
+	void writeText(const std::wstring& str) {
+		m_endpoint->write(str.data(), str.size());
+	}
+
+	// appends non-negative 'n' to 'buffer' at 'len'
+	static void formatNumber(wchar_t* buffer, int& len, int n)
+	{
+		wchar_t digits[12];
+		int numDigits = 0;
+		do {
+			digits[numDigits++] = (wchar_t)(L'0' + n % 10);
+			n /= 10;
+		} while (n > 0);
+		while (numDigits > 0) {
+			buffer[len++] = digits[--numDigits];
+		}
+	}
+
+	// 'ESC [ <n> <command>', formatted without allocating
+	void writeSequence(int n, wchar_t command)
+	{
+		wchar_t seq[16] = { L'\033', L'[' };
+		int len = 2;
+		formatNumber(seq, len, n);
+		seq[len++] = command;
+		m_endpoint->write(seq, len);
+	}
+
+	// resets console style, then switches to 'style' (plain style only resets)
+	void writeStyle(const TextStyle& style)
+	{
+		int params[8];
+		int numParams = ScreenBuffer::getStyleParams(TextStyle(), style, params);
+		wchar_t seq[48] = { L'\033', L'[', L'0' };
+		int len = 3;
+		for (int i = 0; i < numParams; i++) {
+			seq[len++] = L';';
+			formatNumber(seq, len, params[i]);
+		}
+		seq[len++] = L'm';
+		m_endpoint->write(seq, len);
+	}
+
+	// plain text is written as is, styled text is followed by a reset
+	void writeStyled(const wchar_t* str, size_t len, const TextStyle& style)
+	{
+		if (style.isPlain()) {
+			m_endpoint->write(str, len);
+			return;
+		}
+		writeStyle(style);
+		m_endpoint->write(str, len);
+		writeStyle(TextStyle());
+	}
+
+	void writeSpaces(int count)
+	{
+		static const wchar_t SPACES[] = L"                ";
+		const int MAX_CHUNK = (int)(sizeof(SPACES) / sizeof(wchar_t)) - 1;
+		while (count > 0) {
+			int chunk = std::min(count, MAX_CHUNK);
+			m_endpoint->write(SPACES, chunk);
+			count -= chunk;
+		}
+	}
+
+	void clearLine() {
+		writeText(L"\033[2K"); // overwrite current line
+		writeText(L"\033[0G"); // Move cursor to beginning of line
+	}
+
+	void clearLeft(int chars) {
+		writeSequence(chars, L'D'); // Move cursor n characters to the left
+		writeSpaces(chars); // overwrite with spaces
+		writeSequence(chars, L'D'); // reset console cursor to initial position
+	}
+
+	void clearRight(int chars) {
+		writeSpaces(chars); // overwrite with spaces
+		writeSequence(chars, L'D'); // reset console cursor to initial position
+	}
+
+	void moveConsoleCursorLeft(int chars) {
+		if (chars) {
+			writeSequence(chars, L'D');
+		}
+	}
+	
+	void moveConsoleCursorRight(int chars) {
+		if (chars) {
+			writeSequence(chars, L'C');
+		}
+	}
+
+	void moveConsoleCursorUp(int lines) {
+		if (lines) {
+			writeSequence(lines, L'A');
+		}
+	}
+
+	void moveConsoleCursorDown(int lines) {
+		if (lines) {
+			writeSequence(lines, L'B');
+		}
+	}
+
+	// same as 'truncateString()', but written straight to endpoint, without building
+	// any intermediate strings.
+	void writeTruncated(const wchar_t* str, size_t len, const Truncation& truncation)
+	{
+		m_endpoint->write(str, truncation.prefixLen);
+		if (truncation.bMarked) {
+			m_endpoint->write(L"~", 1);
+			m_endpoint->write(str + len - truncation.suffixLen, truncation.suffixLen);
+		}
+	}
+
+	void writeTruncated(const wchar_t* str, size_t len, int maxSize) {
+		writeTruncated(str, len, getTruncation(str, len, maxSize));
+	}
+
+	// case-insensitive, npos if not found
+	static size_t findMatch(const wchar_t* str, size_t len, const std::wstring& query, size_t from)
+	{
+		for (size_t pos = from; pos + query.size() <= len; pos++) {
+			size_t i = 0;
+			while (i < query.size() && towlower(str[pos + i]) == towlower(query[i])) {
+				i++;
+			}
+			if (i == query.size()) {
+				return pos;
+			}
+		}
+		return std::wstring::npos;
+	}
+
+	// for derived menus, reporting their state as options
+	static MenuState makeState(std::vector<Option>& options) {
+		return MenuState(options);
+	}
+
+	static Option makeOption(const std::wstring& optName, const std::wstring& optDescription,
+		BOOL selected)
+	{
+		Option option(optName, optDescription);
+		option._selected = selected;
+		return option;
+	}
+
+	void toggleOption(Option& option) {
+		option._selected = !option._selected;
+	}
+
+	void selectOption(Option& option) {
+		option._selected = TRUE;
+	}
+
+	void unselectOption(Option& option) {
+		option._selected = FALSE;
+	}
+
+	void setOptionSelected(int optIdx, BOOL selected) {
+		if (m_catalog) {
+			m_catalog->setSelected(optIdx, selected);
+		}
+		else {
+			m_options[optIdx]._selected = selected;
+		}
+	}
+
+	void toggleOption(int optIdx) {
+		setOptionSelected(optIdx, !isOptionSelected(optIdx));
+	}
+
+	void selectOption(int optIdx) {
+		setOptionSelected(optIdx, TRUE);
+	}
+
+	void unselectOption(int optIdx) {
+		setOptionSelected(optIdx, FALSE);
+	}
+};
+
+inline BOOL OptionCatalog::write(const std::wstring& path, BasicMenu& menu)
+{
+	if (!menu.hasOptionList()) {
+		return write(path, menu.getState());
+	}
+	return writeCatalog(path, menu.getOptionCount(),
+		[&menu](int idx, const wchar_t*& name, size_t& nameLen,
+			const wchar_t*& desc, size_t& descLen, BOOL& selected) {
+			name = menu.getOptionName(idx, nameLen);
+			if (menu.isDescriptionLazy(idx)) {
+				// not computed up front - left out, as from 'MenuState'
+				desc = L"";
+				descLen = 0;
+			}
+			else {
+				desc = menu.getOptionDescription(idx, descLen);
+			}
+			selected = menu.isOptionSelected(idx);
+		});
+}
+
+/// <summary>
+/// base class for vertical menus
+/// </summary>
+class VerticalMenu : public BasicMenu
+{
+public:
+	virtual void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") override {
+		BasicMenu::addOption(optDisplayName, optDescription);
+		updatePaging();
+		invalidateRowCache();
+	}
+
+	virtual void addOption(const std::wstring& optDisplayName, const DescriptionProvider& descriptionProvider) override {
+		BasicMenu::addOption(optDisplayName, descriptionProvider);
+		updatePaging();
+		invalidateRowCache();
+	}
+
+	virtual BOOL loadCatalog(OptionCatalog& catalog) override
+	{
+		if (!BasicMenu::loadCatalog(catalog)) {
+			return FALSE;
+		}
+		updatePaging();
+		invalidateRowCache();
+		return TRUE;
+	}
+
+	void execute() override
+	{
+		BOOL finitoLaComedia = FALSE;
+
+		start();
+		do
+		{
+			finitoLaComedia = handleKey(readKey());
+		} while (!finitoLaComedia);
+		finish();
+	}
+
+	// STEP-DRIVEN CONTROL
+	// ('execute()' drives these from the console, 'MenuServer' from a session)
+
+	// paints initial frame. nothing is allocated by keys handled from here on.
+	virtual void start()
+	{
+		m_dirtyOptions.reserve(m_OPTIONS_PER_PAGE + 1/*selection on another page*/);
+		hideConsoleCursor();
+		scrollConsole();
+		renderTitle();
+		invalidateLayout();
+		invalidateDescription();
+		presentFrame(TRUE);
+	}
+
+	// updates state by a single key, as returned by '_getch()'.
+	// returns TRUE once the menu is done.
+	virtual BOOL handleKey(int keyPress) = 0;
+
+	// cleanup before exit
+	virtual void finish()
+	{
+		leaveMenu();
+		showConsoleCursor();
+	}
+
+private:
+
+	int renderInstruction(int row, int col)
+	{
+		return m_screen.putText(row, col, m_instruction.c_str(), m_instruction.size());
+	}
+
+	int renderPageInfo(int row, int col, int pageIdx)
+	{
+		int startIdx = pageIdx * m_OPTIONS_PER_PAGE;
+		int endIdx = std::min(startIdx + m_OPTIONS_PER_PAGE, getOptionCount());
+		wchar_t pageInfo[64];
+		int len = swprintf(pageInfo, 64, L"[ %d-%d / %d ]", startIdx + 1, endIdx, getOptionCount());
+		return m_screen.putText(row, col, pageInfo, std::max(len, 0));
+	}
+
+protected:
+
+	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage, 
+		const std::wstring& instruction) 
+		: BasicMenu(menuTitle), 
+		m_cursorStyle(cursorStyle), 
+		m_OPTIONS_PER_PAGE(optsPerPage), 
+		m_instruction(instruction) {};
+
+
+	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, NO_INSTRUCTION) {};
+
+	VerticalMenu(const std::wstring& menuTitle, int optsPerPage,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, optsPerPage, instruction) {};
+
+	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, DEFAULT_OPTIONS_PER_PAGE, instruction) {};
+
+
+	VerticalMenu(const std::wstring& menuTitle, int optsPerPage)
+		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, optsPerPage, 
+			NO_INSTRUCTION) {};
+
+	VerticalMenu(const std::wstring& menuTitle, wchar_t cursorStyle) 
+		: VerticalMenu(menuTitle, cursorStyle, DEFAULT_OPTIONS_PER_PAGE, 
+			NO_INSTRUCTION) {};
+
+	VerticalMenu(const std::wstring& menuTitle,	const std::wstring& instruction)
+		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, DEFAULT_OPTIONS_PER_PAGE, 
+			instruction) {};
+
+
+	VerticalMenu(const std::wstring& menuTitle)	
+		: VerticalMenu(menuTitle, DEFAULT_CURSOR_STYLE, DEFAULT_OPTIONS_PER_PAGE, 
+			NO_INSTRUCTION) {};
+
+	~VerticalMenu() {};
+
+	std::wstring m_instruction;
+	const wchar_t m_cursorStyle;
+	int m_OPTIONS_PER_PAGE;
+	BOOL m_B_USE_PAGING = FALSE;
+	int m_currentPageIdx = 0;
+	int m_totalPages = 0;
+
+	// menu area, rendered by diffing frames
+	ScreenBuffer m_screen;
+
+	// fully formatted option rows, for current screen width - mapped by option index.
+	// cursor and checkbox cells are patched in place on every render.
+	struct CachedRow
+	{
+		int optIdx = -1;
+		std::wstring row;
+		Truncation nameTruncation;
+	};
+	std::vector<CachedRow> m_rowCache;
+	int m_rowCacheWidth = 0;
+
+	void updatePaging()
+	{
+		m_totalPages = (getOptionCount() + m_OPTIONS_PER_PAGE - 1) / m_OPTIONS_PER_PAGE;
+		m_B_USE_PAGING = m_totalPages > 1;
+	}
+
+	// MENU LAYOUT
+	// (rows, relative to title)
+
+	virtual int getPageRows() {
+		return std::min(m_OPTIONS_PER_PAGE, getOptionCount());
+	}
+
+	int getOptionRow(int optIdx) {
+		return 2/*title*/ + optIdx % m_OPTIONS_PER_PAGE;
+	}
+
+	int getDescriptionRow() {
+		return 2/*title*/ + getPageRows() + 1/*for spacing between options and description*/;
+	}
+
+	int getFooterRow() {
+		return getDescriptionRow() + 1;
+	}
+
+	int getMenuRows() {
+		return getFooterRow() + 2/*footer*/;
+	}
+
+	void scrollConsole() override
+	{
+		int totalLines = getMenuRows() + 1/*for spacing after menu*/;
+		std::wstring scroll(totalLines, L'\n');
+		scroll += L"\033[" + std::to_wstring(totalLines) + L"A";
+		m_endpoint->write(scroll.data(), scroll.size());
+		m_endpoint->flush();
+
+		// console cursor is now at first row of menu area
+		m_screen.resize(getConsoleLineSize() - 1/*avoid auto-wrap at last column*/, getMenuRows());
+		m_screen.setOrigin(m_endpoint->getCursorRow());
+	}
+
+	// rebuild menu area from scratch, if console width changed since last frame
+	void fitConsoleWidth()
+	{
+		int width = getConsoleLineSize() - 1/*avoid auto-wrap at last column*/;
+		if (width > 0 && width != m_screen.getWidth()) {
+			m_screen.resize(width, getMenuRows());
+			renderTitle();
+			renderPage(m_currentPageIdx);
+			renderFooter();
+			invalidateDescription();
+		}
+	}
+
+	// place console cursor just after menu area
+	void leaveMenu() {
+		m_screen.moveCursor(getMenuRows() + 1, 0);
+		m_endpoint->flush();
+	}
+
+	// returns column just after rendered text
+	int renderTruncated(int row, int col, const wchar_t* str, size_t len, 
+		const Truncation& truncation)
+	{
+		col = m_screen.putText(row, col, str, truncation.prefixLen);
+		if (truncation.bMarked) {
+			col = m_screen.putChar(row, col, L'~');
+			col = m_screen.putText(row, col, str + len - truncation.suffixLen, truncation.suffixLen);
+		}
+		return col;
+	}
+
+	int renderTruncated(int row, int col, const wchar_t* str, size_t len, int maxSize) {
+		return renderTruncated(row, col, str, len, getTruncation(str, len, maxSize));
+	}
+
+	BOOL isStyled() const
+	{
+		return !m_theme.title.isPlain() || !m_theme.hoveredOption.isPlain() || 
+			!m_theme.selectionMark.isPlain() || !m_theme.description.isPlain() ||
+			!m_theme.footer.isPlain() || (!m_theme.match.isPlain() && !m_matchQuery.empty()) ||
+			!m_optionStyles.empty() || !m_optionSpans.empty();
+	}
+
+	// styles characters [start, end) of a name rendered at 'nameCol' with 'truncation'.
+	// (see 'renderTruncated()')
+	void styleNameRange(int row, int nameCol, const wchar_t* name, size_t nameLen, 
+		const Truncation& truncation, size_t start, size_t end, const TextStyle& style)
+	{
+		end = std::min(end, nameLen);
+		if (start >= end) {
+			return;
+		}
+		size_t prefixLen = truncation.prefixLen;
+		if (start < prefixLen) {
+			size_t prefixEnd = std::min(end, prefixLen);
+			m_screen.applyStyle(row, nameCol + getDisplayWidth(name, start), 
+				getDisplayWidth(name + start, prefixEnd - start), style);
+		}
+		size_t suffixStart = nameLen - truncation.suffixLen;
+		if (truncation.bMarked && end > suffixStart) {
+			size_t from = std::max(start, suffixStart);
+			int suffixCol = nameCol + getDisplayWidth(name, prefixLen) + 1/*truncation mark*/;
+			m_screen.applyStyle(row, suffixCol + getDisplayWidth(name + suffixStart, from - suffixStart), 
+				getDisplayWidth(name + from, end - from), style);
+		}
+	}
+
+	// draws styles of a rendered option row, bottom to top - option's style, spans & 
+	// matches of its name, selection mark, hovered row - up to 'rowEnd'.
+	// ('optIdx' -1 skips option's own styles)
+	void styleOptionRow(int row, int optIdx, BOOL bHovered, BOOL bSelected, int markCol, 
+		int nameCol, const wchar_t* name, size_t nameLen, const Truncation& nameTruncation, int rowEnd)
+	{
+		if (optIdx != -1) {
+			auto styleIt = m_optionStyles.find(optIdx);
+			if (styleIt != m_optionStyles.end()) {
+				m_screen.applyStyle(row, 0, rowEnd, styleIt->second);
+			}
+			auto spansIt = m_optionSpans.find(optIdx);
+			if (spansIt != m_optionSpans.end()) {
+				for (const StyleSpan& span : spansIt->second) {
+					styleNameRange(row, nameCol, name, nameLen, nameTruncation, 
+						span.start, (size_t)span.start + span.length, span.style);
+				}
+			}
+		}
+		if (!m_matchQuery.empty() && !m_theme.match.isPlain()) {
+			size_t pos = findMatch(name, nameLen, m_matchQuery, 0);
+			while (pos != std::wstring::npos) {
+				styleNameRange(row, nameCol, name, nameLen, nameTruncation, 
+					pos, pos + m_matchQuery.size(), m_theme.match);
+				pos = findMatch(name, nameLen, m_matchQuery, pos + m_matchQuery.size());
+			}
+		}
+		if (bSelected) {
+			m_screen.applyStyle(row, markCol, 1, m_theme.selectionMark);
+		}
+		if (bHovered) {
+			m_screen.applyStyle(row, 0, rowEnd, m_theme.hoveredOption);
+		}
+	}
+
+	void renderFooter()
+	{
+		int row = getFooterRow();
+		m_screen.clearRow(row);
+		m_screen.clearRow(row + 1);
+		if (!m_B_USE_PAGING && m_instruction == NO_INSTRUCTION)
+			return;
+
+		m_screen.fill(row, 0, L'-', (int)std::max(m_title.length(), m_instruction.length() + 1));
+
+		int col = 0;
+		if (m_instruction != NO_INSTRUCTION) {
+			col = renderInstruction(row + 1, col);
+			col = m_screen.putText(row + 1, col, L" | ", 3);
+		}
+		if (m_B_USE_PAGING) {
+			col = renderPageInfo(row + 1, col, m_currentPageIdx);
+		}
+		m_screen.applyStyle(row + 1, 0, col, m_theme.footer);
+	}
+
+	void renderTitle() override
+	{
+		m_screen.clearRow(0);
+		m_screen.clearRow(1);
+		m_screen.putText(0, 0, m_title.c_str(), m_title.length(), m_theme.title);
+		m_screen.fill(1, 0, L'-', (int)m_title.length());
+	}
+
+	// formatted row of option, built only once per screen width / label.
+	// rebuilding a row reuses storage of the one it replaces.
+	CachedRow& getFormattedRow(int optIdx)
+	{
+		if (m_rowCacheWidth != m_screen.getWidth()) {
+			resetRowCache();
+		}
+		CachedRow& cachedRow = m_rowCache[optIdx % m_rowCache.size()];
+		if (cachedRow.optIdx != optIdx) {
+			cachedRow.optIdx = optIdx;
+			cachedRow.row.assign(L"  [ ] ");
+			size_t nameLen;
+			const wchar_t* name = getOptionName(optIdx, nameLen);
+			cachedRow.nameTruncation = getTruncation(name, nameLen, 
+				m_screen.getWidth() - (int)cachedRow.row.size() - 1/*truncation mark*/,
+				getOptionNameWidth(optIdx));
+			appendTruncated(cachedRow.row, name, nameLen, cachedRow.nameTruncation);
+		}
+		return cachedRow;
+	}
+
+	// a row per option (up to ROW_CACHE_SIZE), each allocated for a full screen line
+	void resetRowCache()
+	{
+		m_rowCacheWidth = m_screen.getWidth();
+		m_rowCache.resize(std::max(std::min((size_t)getOptionCount(), ROW_CACHE_SIZE), (size_t)1));
+		for (CachedRow& cachedRow : m_rowCache) {
+			cachedRow.optIdx = -1;
+			cachedRow.row.reserve(m_rowCacheWidth);
+		}
+	}
+
+	// rebuilt on next render
+	void invalidateRowCache() {
+		m_rowCacheWidth = 0;
+	}
+
+	void onOptionRelabeled(int optIdx) override 
+	{
+		if (!m_rowCache.empty() && m_rowCache[optIdx % m_rowCache.size()].optIdx == optIdx) {
+			m_rowCache[optIdx % m_rowCache.size()].optIdx = -1;
+		}
+	}
+
+	void onOptionsAdded() override {
+		updatePaging();
+		invalidateRowCache();
+	}
+
+	void setEndpoint(MenuEndpoint& endpoint) override
+	{
+		BasicMenu::setEndpoint(endpoint);
+		m_screen.setEndpoint(endpoint);
+	}
+
+	void renderOption(int optIdx) override
+	{
+		CachedRow& cachedRow = getFormattedRow(optIdx);
+		std::wstring& formattedRow = cachedRow.row;
+
+		// patch cursor & checkbox cells
+		BOOL bHovered = m_menuCursorPos == optIdx % m_OPTIONS_PER_PAGE;
+		BOOL bSelected = isOptionSelected(optIdx);
+		formattedRow[0] = bHovered ? m_cursorStyle : L' ';
+		formattedRow[3] = bSelected ? L'*' : L' ';
+		int row = getOptionRow(optIdx);
+		m_screen.putRow(row, formattedRow.data(), formattedRow.size());
+
+		if (isStyled()) {
+			size_t nameLen;
+			const wchar_t* name = getOptionName(optIdx, nameLen);
+			styleOptionRow(row, optIdx, bHovered, bSelected, 3, 6, name, nameLen, 
+				cachedRow.nameTruncation, 6 + cachedRow.nameTruncation.width);
+		}
+	}
+
+	BOOL isOptionInPage(int optIdx, int pageIdx) {
+		int startIdx = pageIdx * m_OPTIONS_PER_PAGE;
+		int endIdx = std::min(startIdx + m_OPTIONS_PER_PAGE, getOptionCount());
+
+		if (optIdx < endIdx && optIdx >= startIdx) {
+			return TRUE;
+		}
+		return FALSE;
+	}
+
+	int getNumOptionsInPage(int pageIdx) {
+		return std::min(m_OPTIONS_PER_PAGE, 
+			getOptionCount() - pageIdx * m_OPTIONS_PER_PAGE);
+	}
+
+	void deletePage() {
+		for (int i = 0; i < getPageRows(); i++) {
+			m_screen.clearRow(getOptionRow(i));
+		}
+	}
+
+	// adjust menu cursor position, if needed
+	void clampMenuCursor(int pageIdx) {
+		int numOptionsInPage = getNumOptionsInPage(pageIdx);
+		if (m_menuCursorPos > numOptionsInPage - 1) {
+			m_menuCursorPos = numOptionsInPage - 1;
+		}
+	}
+
+	void renderPage(int pageIdx) {
 		deletePage();
 		int numOptionsInPage = getNumOptionsInPage(pageIdx);
+		clampMenuCursor(pageIdx);
+
+		for (int i = pageIdx * m_OPTIONS_PER_PAGE;
+			i < pageIdx * m_OPTIONS_PER_PAGE + numOptionsInPage;
+			i++
+		) {
+			renderOption(i);
+		}
+	}
+
+	int getHoveredOptionIdx() override {
+		return m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos;
+	}
+
+	BOOL isOptionDisplayed(int optIdx) override {
+		return isOptionInPage(optIdx, m_currentPageIdx);
+	}
+
+	// switch page, and invalidate accordingly
+	void turnPage(int pageIdx) {
+		m_currentPageIdx = pageIdx;
+		clampMenuCursor(pageIdx);
+		invalidateLayout();
+		invalidateDescription();
+	}
+
+	// draws invalidated parts into back buffer, then writes only what changed on screen
+	void paintFrame() override
+	{
+		fitConsoleWidth();
+		if (m_bLayoutDirty) {
+			renderPage(m_currentPageIdx);
+			renderFooter();
+		}
+		else {
+			for (int optIdx : m_dirtyOptions) {
+				if (isOptionInPage(optIdx, m_currentPageIdx)) {
+					renderOption(optIdx);
+				}
+			}
+		}
+		if (m_bDescriptionDirty) {
+			renderDescription(getHoveredOptionIdx());
+		}
+		m_screen.flush();
+	}
+
+	void hideMenuCursor() {
+		m_menuCursorPos = -1;
+
+		// refresh all options
+		renderPage(m_currentPageIdx);
+	}
+
+	void deleteDescription() override {
+		m_screen.clearRow(getDescriptionRow());
+	}
+
+	void renderDescription(int optIdx) override {
+		requestDescription(optIdx);
+		deleteDescription();
+		
+		size_t descLen;
+		const wchar_t* desc = getOptionDescription(optIdx, descLen);
+		int col = renderTruncated(getDescriptionRow(), 0, desc, descLen, 
+			m_screen.getWidth() - 1/*truncation mark*/);
+		m_screen.applyStyle(getDescriptionRow(), 0, col, m_theme.description);
+	}
+};
+
+/// <summary>
+/// Allows the user to choose any amount of option from a list of options.
+/// </summary>
+class CheckboxMenu : public VerticalMenu
+{
+public:
+	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle, 
+		int optsPerPage, const std::wstring& instruction) 
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, instruction) {};
+
+
+	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage) {};
+
+	CheckboxMenu(const std::wstring& menuTitle, int optsPerPage,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, optsPerPage, instruction) {};
+
+	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle, 
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, instruction) {};
+
+
+	CheckboxMenu(const std::wstring& menuTitle, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, instruction) {};
+
+	CheckboxMenu(const std::wstring& menuTitle, int optsPerPage) 
+		: VerticalMenu(menuTitle, optsPerPage) {};
+
+	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle) 
+		: VerticalMenu(menuTitle, cursorStyle) {};
+
+
+	CheckboxMenu(const std::wstring& menuTitle)
+		: VerticalMenu(menuTitle) {};
+
+
+	void addOption(const std::wstring& optDisplayName, 
+		const std::wstring& optDescription = L"", BOOL isSelectedByDefault = FALSE) {
+		VerticalMenu::addOption(optDisplayName, optDescription);
+		if (isSelectedByDefault) {
+			toggleOption(m_options.back());
+		}
+	}
+
+	void addOption(const std::wstring& optDisplayName,
+		const DescriptionProvider& descriptionProvider, BOOL isSelectedByDefault = FALSE) {
+		VerticalMenu::addOption(optDisplayName, descriptionProvider);
+		if (isSelectedByDefault) {
+			toggleOption(m_options.back());
+		}
+	}
+
+	// MENU CONTROL
+	// (update state by a single key)
+	BOOL handleKey(int keyPress) override
+	{
+		BOOL finitoLaComedia = FALSE;
+
+		switch (keyPress)
+		{
+		case KEY_SPACEBAR:
+			toggleOption(getHoveredOptionIdx());
+			break;
+		case KEY_ARROW_UP:
+			if (m_menuCursorPos > 0) {
+				invalidateOption(getHoveredOptionIdx());
+				m_menuCursorPos--;
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_DOWN:
+			if (m_menuCursorPos < getNumOptionsInPage(m_currentPageIdx) - 1) {
+				invalidateOption(getHoveredOptionIdx());
+				m_menuCursorPos++;
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_LEFT:
+			if (m_B_USE_PAGING && m_currentPageIdx > 0) {
+				turnPage(m_currentPageIdx - 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_RIGHT:
+			if (m_B_USE_PAGING && m_currentPageIdx < m_totalPages - 1) {
+				turnPage(m_currentPageIdx + 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ENTER:
+			finitoLaComedia = TRUE;
+			break;
+		default:
+			return FALSE;
+		}
+
+		invalidateOption(getHoveredOptionIdx());
+		presentFrame(finitoLaComedia/*final state is always painted*/);
+		return finitoLaComedia;
+	}
+
+private:
+protected:
+};
+
+/// <summary>
+/// Allows the user to choose one option from a list of options,
+/// where selecting one option deselects any previously selected option.
+/// </summary>
+class RadioMenu : public VerticalMenu
+{
+public:
+	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		int optsPerPage, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, instruction) {};
+
+
+	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage) {};
+
+	RadioMenu(const std::wstring& menuTitle, int optsPerPage,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, optsPerPage, instruction) {};
+
+	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, instruction) {};
+
+
+	RadioMenu(const std::wstring& menuTitle, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, instruction) {};
+
+	RadioMenu(const std::wstring& menuTitle, int optsPerPage)
+		: VerticalMenu(menuTitle, optsPerPage) {};
+
+	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle)
+		: VerticalMenu(menuTitle, cursorStyle) {};
+
+
+	RadioMenu(const std::wstring& menuTitle)
+		: VerticalMenu(menuTitle) {};
+
+	// selection stored in catalog is restored - last selected option wins
+	BOOL loadCatalog(OptionCatalog& catalog) override
+	{
+		if (!VerticalMenu::loadCatalog(catalog)) {
+			return FALSE;
+		}
+		m_selectedOptIdx = -1;
+		for (int optIdx = 0; optIdx < getOptionCount(); optIdx++) {
+			if (isOptionSelected(optIdx)) {
+				if (m_selectedOptIdx != -1) {
+					unselectOption(m_selectedOptIdx);
+				}
+				m_selectedOptIdx = optIdx;
+			}
+		}
+		return TRUE;
+	}
+
+	// MENU CONTROL
+	// (update state by a single key)
+	BOOL handleKey(int keyPress) override
+	{
+		BOOL finitoLaComedia = FALSE;
+
+		switch (keyPress)
+		{
+		case KEY_SPACEBAR:
+			// un-select selected option, if one is selected
+ 				if (m_selectedOptIdx != -1) {
+				unselectOption(m_selectedOptIdx);
+				invalidateOption(m_selectedOptIdx);
+			}
+			toggleOption(getHoveredOptionIdx());
+			m_selectedOptIdx = getHoveredOptionIdx();
+			break;
+		case KEY_ARROW_UP:
+			if (m_menuCursorPos > 0) {
+				invalidateOption(getHoveredOptionIdx());
+				m_menuCursorPos--;
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_DOWN:
+			if (m_menuCursorPos < getNumOptionsInPage(m_currentPageIdx) - 1) {
+				invalidateOption(getHoveredOptionIdx());
+				m_menuCursorPos++;
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_LEFT:
+			if (m_currentPageIdx > 0) {
+				turnPage(m_currentPageIdx - 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_RIGHT:
+			if (m_currentPageIdx < m_totalPages - 1) {
+				turnPage(m_currentPageIdx + 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ENTER:
+			// prevent exit until an option is selected
+			if (m_selectedOptIdx != -1) {
+				finitoLaComedia = TRUE;
+			}
+			break;
+		default:
+			return FALSE;
+		}
+
+		invalidateOption(getHoveredOptionIdx());
+		presentFrame(finitoLaComedia/*final state is always painted*/);
+		return finitoLaComedia;
+	}
+
+private:
+	int m_selectedOptIdx = -1;
+
+protected:
+	// last option selected by default wins
+	void insertOption(std::wstring&& optDisplayName, std::wstring&& optDescription,
+		BOOL isSelectedByDefault) override
+	{
+		VerticalMenu::insertOption(std::move(optDisplayName), std::move(optDescription), FALSE);
+		if (isSelectedByDefault) {
+			if (m_selectedOptIdx != -1) {
+				unselectOption(m_selectedOptIdx);
+			}
+			m_selectedOptIdx = (int)m_options.size() - 1;
+			selectOption(m_selectedOptIdx);
+		}
+	}
+};
+
+/// <summary>
+/// prefix sums over a growable array of counts, in O(log n) per update / query.
+/// </summary>
+class FenwickTree
+{
+public:
+	int size() const {
+		return (int)m_tree.size();
+	}
+
+	int total() const {
+		return m_total;
+	}
+
+	// sum of counts [0, idx)
+	int prefix(int idx) const
+	{
+		int sum = 0;
+		for (; idx > 0; idx -= idx & -idx) {
+			sum += m_tree[idx - 1];
+		}
+		return sum;
+	}
+
+	void add(int idx, int delta)
+	{
+		m_total += delta;
+		for (idx++; idx <= size(); idx += idx & -idx) {
+			m_tree[idx - 1] += delta;
+		}
+	}
+
+	void append(int count)
+	{
+		int idx = size() + 1;
+		int lowBit = idx & -idx;
+		m_tree.push_back(count + prefix(idx - 1) - prefix(idx - lowBit));
+		m_total += count;
+	}
+
+	// smallest idx such that prefix(idx + 1) > pos. expects 0 <= pos < total().
+	int find(int pos) const
+	{
+		int idx = 0;
+		int step = 1;
+		while (step * 2 <= size()) {
+			step *= 2;
+		}
+		for (; step > 0; step /= 2) {
+			if (idx + step <= size() && m_tree[idx + step - 1] <= pos) {
+				idx += step;
+				pos -= m_tree[idx - 1];
+			}
+		}
+		return idx;
+	}
+
+private:
+	std::vector<int> m_tree;
+	int m_total = 0;
+};
+
+const int TREE_ROOT = -1;
+
+// called once a node is first expanded, to add its children via 'TreeMenu::addNode()'
+typedef std::function<void(int nodeId)> ChildrenLoader;
+
+/// <summary>
+/// Allows the user to browse a hierarchy, expanding and collapsing nodes, 
+/// and to check any amount of nodes. checking a node checks its whole subtree, and
+/// nodes with only part of their subtree checked are displayed as partially checked.
+/// children may be loaded lazily, only once their parent is expanded.
+/// </summary>
+class TreeMenu : public VerticalMenu
+{
+public:
+	enum CheckState : uint8_t
+	{
+		UNCHECKED,
+		CHECKED,
+		PARTIAL
+	};
+
+	TreeMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		int optsPerPage, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, instruction) {};
+
+
+	TreeMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage) {};
+
+	TreeMenu(const std::wstring& menuTitle, int optsPerPage,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, optsPerPage, instruction) {};
+
+	TreeMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, instruction) {};
+
+
+	TreeMenu(const std::wstring& menuTitle, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, instruction) {};
+
+	TreeMenu(const std::wstring& menuTitle, int optsPerPage)
+		: VerticalMenu(menuTitle, optsPerPage) {};
+
+	TreeMenu(const std::wstring& menuTitle, wchar_t cursorStyle)
+		: VerticalMenu(menuTitle, cursorStyle) {};
+
+
+	TreeMenu(const std::wstring& menuTitle)
+		: VerticalMenu(menuTitle) {};
+
+	// adds a node under 'parentId' (or a top level node, for TREE_ROOT), returns its id.
+	// expandable nodes without children get them from the children loader, once expanded.
+	int addNode(int parentId, std::wstring name, 
+		std::wstring description = L"", BOOL bExpandable = FALSE)
+	{
+		int nodeId = (int)m_nodes.size();
+		m_nodes.emplace_back();
+		TreeNode& node = m_nodes.back();
+		TreeNode& parent = getNode(parentId);
+		node.name = std::move(name);
+		node.description = std::move(description);
+		node.parentId = parentId;
+		node.depth = parentId == TREE_ROOT ? 0 : parent.depth + 1;
+		node.childIdx = (int)parent.children.size();
+		node.bExpandable = bExpandable;
+
+		// new children inherit a fully (un)checked parent
+		node.checkState = parent.checkState == CHECKED ? CHECKED : UNCHECKED;
+
+		parent.children.push_back(nodeId);
+		parent.childRows.append(1);
+		parent.bExpandable = TRUE;
+		parent.bLoaded = TRUE;
+		if (parent.checkState == CHECKED) {
+			parent.numCheckedChildren++;
+		}
+		else if (parentId != TREE_ROOT) {
+			CheckState oldState = parent.checkState;
+			updateCheckState(parentId);
+			onChildStateChanged(parent.parentId, oldState, parent.checkState);
+		}
+		if (parentId != TREE_ROOT && parent.bExpanded) {
+			propagateRows(parentId, 1);
+		}
+		updatePaging();
+		return nodeId;
+	}
+
+	// top level node
+	void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") override {
+		addNode(TREE_ROOT, optDisplayName, optDescription);
+	}
+
+	void setChildrenLoader(const ChildrenLoader& loader) {
+		m_childrenLoader = loader;
+	}
+
+	CheckState getCheckState(int nodeId) {
+		return getNode(nodeId).checkState;
+	}
+
+	// all loaded nodes, by id. partially checked nodes are reported unselected.
+	MenuState getState() override
+	{
+		std::vector<Option> options;
+		options.reserve(m_nodes.size());
+		for (const TreeNode& node : m_nodes) {
+			options.push_back(makeOption(node.name, node.description, node.checkState == CHECKED));
+		}
+		return makeState(options);
+	}
+
+	// MENU CONTROL
+	// (update state by a single key)
+	BOOL handleKey(int keyPress) override
+	{
+		BOOL finitoLaComedia = FALSE;
+
+		if (getOptionCount() == 0) {
+			return keyPress == KEY_ENTER;
+		}
+		int rowIdx = getHoveredOptionIdx();
+		int nodeId = getNodeAtRow(rowIdx);
+		switch (keyPress)
+		{
+		case KEY_SPACEBAR:
+			toggleNode(nodeId);
+			invalidateLayout(); // ancestors & descendants may change as well
+			break;
+		case KEY_ARROW_UP:
+			if (rowIdx > 0) {
+				moveToRow(rowIdx - 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_DOWN:
+			if (rowIdx < getOptionCount() - 1) {
+				moveToRow(rowIdx + 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_LEFT:
+			if (getNode(nodeId).bExpanded) {
+				collapseNode(nodeId);
+				break;
+			}
+			if (getNode(nodeId).parentId != TREE_ROOT) {
+				moveToRow(getRowOfNode(getNode(nodeId).parentId));
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_RIGHT:
+			if (getNode(nodeId).bExpandable && !getNode(nodeId).bExpanded) {
+				expandNode(nodeId);
+				break;
+			}
+			if (getNode(nodeId).bExpanded && !getNode(nodeId).children.empty()) {
+				moveToRow(rowIdx + 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ENTER:
+			finitoLaComedia = TRUE;
+			break;
+		default:
+			return FALSE;
+		}
+
+		invalidateOption(getHoveredOptionIdx());
+		presentFrame(finitoLaComedia/*final state is always painted*/);
+		return finitoLaComedia;
+	}
+
+private:
+	struct TreeNode
+	{
+		std::wstring name;
+		std::wstring description;
+		int parentId = TREE_ROOT;
+		int depth = 0;
+		int childIdx = 0;				// position within parent's children
+		std::vector<int> children;
+		FenwickTree childRows;			// visible rows of each child subtree
+		BOOL bExpandable = FALSE;
+		BOOL bExpanded = FALSE;
+		BOOL bLoaded = FALSE;
+		CheckState checkState = UNCHECKED;
+		int numCheckedChildren = 0;
+		int numPartialChildren = 0;
+	};
+
+	TreeNode m_root;
+	std::vector<TreeNode> m_nodes;
+	ChildrenLoader m_childrenLoader;
+
+	TreeNode& getNode(int nodeId) {
+		return nodeId == TREE_ROOT ? m_root : m_nodes[nodeId];
+	}
+
+	// adds 'delta' rows to subtree of 'nodeId', up to first collapsed ancestor
+	void propagateRows(int nodeId, int delta)
+	{
+		while (nodeId != TREE_ROOT) {
+			TreeNode& node = getNode(nodeId);
+			getNode(node.parentId).childRows.add(node.childIdx, delta);
+			nodeId = node.parentId;
+			if (nodeId != TREE_ROOT && !getNode(nodeId).bExpanded) {
+				return;
+			}
+		}
+	}
+
+	// O(depth * log(fanout))
+	int getNodeAtRow(int rowIdx)
+	{
+		int nodeId = TREE_ROOT;
+		while (true) {
+			TreeNode& node = getNode(nodeId);
+			int childIdx = node.childRows.find(rowIdx);
+			rowIdx -= node.childRows.prefix(childIdx);
+			nodeId = node.children[childIdx];
+			if (rowIdx == 0) {
+				return nodeId;
+			}
+			rowIdx--; // for the child itself
+		}
+	}
+
+	// O(depth * log(fanout))
+	int getRowOfNode(int nodeId)
+	{
+		int rowIdx = 0;
+		for (int id = nodeId; id != TREE_ROOT; id = getNode(id).parentId) {
+			int parentId = getNode(id).parentId;
+			rowIdx += getNode(parentId).childRows.prefix(getNode(id).childIdx);
+			if (parentId != TREE_ROOT) {
+				rowIdx++; // for the parent itself
+			}
+		}
+		return rowIdx;
+	}
+
+	void expandNode(int nodeId)
+	{
+		if (!getNode(nodeId).bLoaded) {
+			getNode(nodeId).bLoaded = TRUE;
+			if (m_childrenLoader) {
+				m_childrenLoader(nodeId);
+			}
+			if (getNode(nodeId).children.empty()) {
+				getNode(nodeId).bExpandable = FALSE;
+				invalidateOption(getHoveredOptionIdx());
+				return;
+			}
+		}
+		getNode(nodeId).bExpanded = TRUE;
+		propagateRows(nodeId, getNode(nodeId).childRows.total());
+		updatePaging();
+		invalidateLayout();
+	}
+
+	void collapseNode(int nodeId)
+	{
+		propagateRows(nodeId, -getNode(nodeId).childRows.total());
+		getNode(nodeId).bExpanded = FALSE;
+		updatePaging();
+		invalidateLayout();
+	}
+
+	void moveToRow(int rowIdx)
+	{
+		invalidateOption(getHoveredOptionIdx());
+		int pageIdx = rowIdx / m_OPTIONS_PER_PAGE;
+		m_menuCursorPos = rowIdx % m_OPTIONS_PER_PAGE;
+		if (pageIdx != m_currentPageIdx) {
+			turnPage(pageIdx);
+		}
+		invalidateDescription();
+	}
+
+	// sets whole subtree, then recounts ancestors
+	void toggleNode(int nodeId)
+	{
+		CheckState newState = getNode(nodeId).checkState == CHECKED ? UNCHECKED : CHECKED;
+		CheckState oldState = getNode(nodeId).checkState;
+
+		std::vector<int> pending = { nodeId };
+		while (!pending.empty()) {
+			TreeNode& node = getNode(pending.back());
+			pending.pop_back();
+			node.checkState = newState;
+			node.numCheckedChildren = newState == CHECKED ? (int)node.children.size() : 0;
+			node.numPartialChildren = 0;
+			pending.insert(pending.end(), node.children.begin(), node.children.end());
+		}
+		onChildStateChanged(getNode(nodeId).parentId, oldState, newState);
+	}
+
+	// updates counts of ancestors, as long as their state changes. O(depth)
+	void onChildStateChanged(int parentId, CheckState oldState, CheckState newState)
+	{
+		while (parentId != TREE_ROOT && oldState != newState) {
+			TreeNode& parent = getNode(parentId);
+			parent.numCheckedChildren += (newState == CHECKED) - (oldState == CHECKED);
+			parent.numPartialChildren += (newState == PARTIAL) - (oldState == PARTIAL);
+			oldState = parent.checkState;
+			updateCheckState(parentId);
+			newState = parent.checkState;
+			parentId = parent.parentId;
+		}
+	}
+
+	// derives state of a parent from its children counts
+	void updateCheckState(int nodeId)
+	{
+		TreeNode& node = getNode(nodeId);
+		if (node.children.empty()) {
+			return;
+		}
+		if (node.numCheckedChildren == (int)node.children.size()) {
+			node.checkState = CHECKED;
+		}
+		else if (node.numCheckedChildren == 0 && node.numPartialChildren == 0) {
+			node.checkState = UNCHECKED;
+		}
+		else {
+			node.checkState = PARTIAL;
+		}
+	}
+
+	// nodes have plain descriptions - a provider is only reachable through 'BasicMenu', 
+	// and computed right away
+	void addOption(const std::wstring& optDisplayName, const DescriptionProvider& descriptionProvider) override {
+		addNode(TREE_ROOT, optDisplayName, descriptionProvider());
+	}
+
+protected:
+
+	// nodes, not an option list
+	BOOL hasOptionList() const override {
+		return FALSE;
+	}
+
+	// styles are keyed by node id, whose row moves as nodes expand and collapse
+	void onOptionStyled(int nodeId) override {
+		invalidateLayout();
+	}
+
+	int getOptionCount() const override {
+		return m_root.childRows.total();
+	}
+
+	// bulk options become top level nodes
+	void insertOption(std::wstring&& optDisplayName, std::wstring&& optDescription,
+		BOOL isSelectedByDefault) override
+	{
+		int nodeId = addNode(TREE_ROOT, std::move(optDisplayName), std::move(optDescription));
+		if (isSelectedByDefault) {
+			toggleNode(nodeId);
+		}
+	}
+
+	void reserveOptions(size_t count) override {
+		m_nodes.reserve(m_nodes.size() + count);
+	}
+
+	// menu height stays fixed, as rows come and go
+	int getPageRows() override {
+		return m_OPTIONS_PER_PAGE;
+	}
+
+	void renderOption(int rowIdx) override
+	{
+		int row = getOptionRow(rowIdx);
+		m_screen.clearRow(row);
+		int nodeId = getNodeAtRow(rowIdx);
+		TreeNode& node = getNode(nodeId);
+
+		BOOL bHovered = m_menuCursorPos == rowIdx % m_OPTIONS_PER_PAGE;
+		int col = m_screen.putChar(row, 0, bHovered ? m_cursorStyle : L' ');
+		col = m_screen.putText(row, col, L" [", 2);
+		col = m_screen.putChar(row, col, 
+			node.checkState == CHECKED ? L'*' : (node.checkState == PARTIAL ? L'~' : L' '));
+		col = m_screen.putText(row, col, L"] ", 2);
+		col = m_screen.fill(row, col, L' ', 2 * node.depth);
+		col = m_screen.putChar(row, col,
+			node.bExpandable ? (node.bExpanded ? L'-' : L'+') : L' ');
+		col = m_screen.putChar(row, col, L' ');
+		Truncation nameTruncation = getTruncation(node.name.c_str(), node.name.size(), 
+			m_screen.getWidth() - col - 1/*truncation mark*/);
+		int nameEnd = renderTruncated(row, col, node.name.c_str(), node.name.size(), nameTruncation);
+
+		if (isStyled()) {
+			styleOptionRow(row, nodeId, bHovered, node.checkState != UNCHECKED, 3, col, 
+				node.name.c_str(), node.name.size(), nameTruncation, nameEnd);
+		}
+	}
+
+	void renderDescription(int rowIdx) override
+	{
+		deleteDescription();
+		if (rowIdx >= getOptionCount()) {
+			return;
+		}
+		TreeNode& node = getNode(getNodeAtRow(rowIdx));
+		int col = renderTruncated(getDescriptionRow(), 0, node.description.c_str(), node.description.size(),
+			m_screen.getWidth() - 1/*truncation mark*/);
+		m_screen.applyStyle(getDescriptionRow(), 0, col, m_theme.description);
+	}
+};
+
+/// <summary>
+/// Allows the user to choose any amount of records, displayed as a table of aligned columns.
+/// rows are stored by column - cells of each column back to back, in one buffer.
+/// tab moves focus between columns, 's' sorts rows by focused column (again to reverse).
+/// </summary>
+class TableMenu : public VerticalMenu
+{
+public:
+	enum Alignment : uint8_t
+	{
+		ALIGN_LEFT,
+		ALIGN_RIGHT
+	};
+
+	TableMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		int optsPerPage, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, instruction) {};
+
+
+	TableMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
+		: VerticalMenu(menuTitle, cursorStyle, optsPerPage) {};
+
+	TableMenu(const std::wstring& menuTitle, int optsPerPage,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, optsPerPage, instruction) {};
+
+	TableMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
+		const std::wstring& instruction)
+		: VerticalMenu(menuTitle, cursorStyle, instruction) {};
+
+
+	TableMenu(const std::wstring& menuTitle, const std::wstring& instruction)
+		: VerticalMenu(menuTitle, instruction) {};
+
+	TableMenu(const std::wstring& menuTitle, int optsPerPage)
+		: VerticalMenu(menuTitle, optsPerPage) {};
+
+	TableMenu(const std::wstring& menuTitle, wchar_t cursorStyle)
+		: VerticalMenu(menuTitle, cursorStyle) {};
+
+
+	TableMenu(const std::wstring& menuTitle)
+		: VerticalMenu(menuTitle) {};
+
+	// returns index of the column. cells wider than 'maxWidth' are truncated.
+	int addColumn(const std::wstring& header, Alignment alignment = ALIGN_LEFT,
+		int maxWidth = DEFAULT_MAX_COLUMN_WIDTH)
+	{
+		m_columns.emplace_back();
+		TableColumn& column = m_columns.back();
+		column.header = header;
+		column.alignment = alignment;
+		column.maxWidth = std::max(maxWidth, 1);
+		column.offsets.assign(m_numRows + 1, 0); // existing rows get empty cells
+		m_bWidthsStale = TRUE;
+		invalidateLayout();
+		return (int)m_columns.size() - 1;
+	}
+
+	// cells beyond the amount of columns are ignored, missing ones are left empty
+	void addRow(const std::vector<std::wstring>& cells, BOOL isSelectedByDefault = FALSE)
+	{
+		for (size_t colIdx = 0; colIdx < m_columns.size(); colIdx++) {
+			TableColumn& column = m_columns[colIdx];
+			if (colIdx < cells.size()) {
+				column.text.insert(column.text.end(), cells[colIdx].begin(), cells[colIdx].end());
+			}
+			column.offsets.push_back((uint32_t)column.text.size());
+		}
+		m_selected.push_back(isSelectedByDefault ? 1 : 0);
+		if (!m_order.empty()) {
+			// appended after sorted rows - no longer sorted
+			m_order.push_back(m_numRows);
+			m_sortColumn = -1;
+		}
+		m_numRows++;
+		m_bWidthsStale = TRUE;
+		updatePaging();
+	}
+
+	// room for 'numRows' more rows, of about 'charsPerCell' characters per cell
+	void reserveRows(size_t numRows, size_t charsPerCell = 16)
+	{
+		for (TableColumn& column : m_columns) {
+			column.offsets.reserve(column.offsets.size() + numRows);
+			column.text.reserve(column.text.size() + numRows * charsPerCell);
+		}
+		m_selected.reserve(m_selected.size() + numRows);
+	}
+
+	// name & description fill the first two columns
+	void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") override {
+		addRow({ optDisplayName, optDescription });
+	}
+
+	int getColumnCount() const {
+		return (int)m_columns.size();
+	}
+
+	// by order of addition, regardless of sorting
+	std::wstring getCell(int rowId, int colIdx) const
+	{
+		size_t len;
+		const wchar_t* text = getCellText(m_columns[colIdx], rowId, len);
+		return std::wstring(text, len);
+	}
+
+	BOOL isRowSelected(int rowId) const {
+		return m_selected[rowId];
+	}
+
+	// all rows, by order of addition. option names are their cells, separated by tabs.
+	MenuState getState() override
+	{
+		std::vector<Option> options;
+		options.reserve(m_numRows);
+		std::wstring name;
+		for (int rowId = 0; rowId < m_numRows; rowId++) {
+			name.clear();
+			for (size_t colIdx = 0; colIdx < m_columns.size(); colIdx++) {
+				size_t len;
+				const wchar_t* text = getCellText(m_columns[colIdx], rowId, len);
+				if (colIdx > 0) {
+					name.push_back(L'\t');
+				}
+				name.append(text, len);
+			}
+			options.push_back(makeOption(name, L"", m_selected[rowId]));
+		}
+		return makeState(options);
+	}
+
+	// MENU CONTROL
+	// (update state by a single key)
+	BOOL handleKey(int keyPress) override
+	{
+		BOOL finitoLaComedia = FALSE;
+
+		if (getOptionCount() == 0) {
+			return keyPress == KEY_ENTER;
+		}
+		switch (keyPress)
+		{
+		case KEY_SPACEBAR:
+			m_selected[getRowAt(getHoveredOptionIdx())] ^= 1;
+			break;
+		case KEY_ARROW_UP:
+			if (m_menuCursorPos > 0) {
+				invalidateOption(getHoveredOptionIdx());
+				m_menuCursorPos--;
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_DOWN:
+			if (m_menuCursorPos < getNumOptionsInPage(m_currentPageIdx) - 1) {
+				invalidateOption(getHoveredOptionIdx());
+				m_menuCursorPos++;
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_LEFT:
+			if (m_B_USE_PAGING && m_currentPageIdx > 0) {
+				turnPage(m_currentPageIdx - 1);
+				break;
+			}
+			return FALSE;
+		case KEY_ARROW_RIGHT:
+			if (m_B_USE_PAGING && m_currentPageIdx < m_totalPages - 1) {
+				turnPage(m_currentPageIdx + 1);
+				break;
+			}
+			return FALSE;
+		case KEY_TAB:
+			if (m_columns.size() > 1) {
+				m_focusedColumn = (m_focusedColumn + 1) % (int)m_columns.size();
+				invalidateLayout();
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_SORT:
+			if (!m_columns.empty()) {
+				sortByColumn(m_focusedColumn);
+				invalidateLayout();
+				invalidateDescription();
+				break;
+			}
+			return FALSE;
+		case KEY_ENTER:
+			finitoLaComedia = TRUE;
+			break;
+		default:
+			return FALSE;
+		}
+
+		invalidateOption(getHoveredOptionIdx());
+		presentFrame(finitoLaComedia/*final state is always painted*/);
+		return finitoLaComedia;
+	}
+
+private:
+	struct TableColumn
+	{
+		std::wstring header;
+		Alignment alignment = ALIGN_LEFT;
+		int maxWidth = DEFAULT_MAX_COLUMN_WIDTH;
+		int width = 0;					// as displayed, see 'updateColumnWidths()'
+		std::vector<wchar_t> text;		// cells, back to back
+		std::vector<uint32_t> offsets;	// cell of row i spans [offsets[i], offsets[i + 1])
+	};
+
+	std::vector<TableColumn> m_columns;
+	std::vector<uint8_t> m_selected;	// by row id
+	int m_numRows = 0;
+	BOOL m_bWidthsStale = TRUE;
+	int m_focusedColumn = 0;
+
+	// cells are plain text - a provider is only reachable through 'BasicMenu', 
+	// and computed right away
+	void addOption(const std::wstring& optDisplayName, const DescriptionProvider& descriptionProvider) override {
+		addRow({ optDisplayName, descriptionProvider() });
+	}
+
+	// display position -> row id, once sorted (identity until then)
+	std::vector<int> m_order;
+	int m_sortColumn = -1;
+	BOOL m_bSortDescending = FALSE;
+
+	static const wchar_t* getCellText(const TableColumn& column, int rowId, size_t& len)
+	{
+		uint32_t start = column.offsets[rowId];
+		len = column.offsets[rowId + 1] - start;
+		return column.text.data() + start;
+	}
+
+	static int getCellWidth(const TableColumn& column, int rowId)
+	{
+		size_t len;
+		const wchar_t* text = getCellText(column, rowId, len);
+		return getDisplayWidth(text, len);
+	}
+
+	int getRowAt(int pos) const {
+		return m_order.empty() ? pos : m_order[pos];
+	}
+
+	// widths fit headers and a sample of cells - first page, then evenly spaced rows,
+	// up to COLUMN_WIDTH_SAMPLE_SIZE. wider cells are truncated once rendered.
+	void updateColumnWidths()
+	{
+		int sampleStride = std::max(m_numRows / COLUMN_WIDTH_SAMPLE_SIZE, 1);
+		int firstPageRows = std::min(m_numRows, m_OPTIONS_PER_PAGE);
+		for (TableColumn& column : m_columns) {
+			int width = getDisplayWidth(column.header.c_str(), column.header.size()) + 2/*sort mark*/;
+			for (int rowId = 0; rowId < firstPageRows; rowId++) {
+				width = std::max(width, getCellWidth(column, rowId));
+			}
+			for (int rowId = firstPageRows; rowId < m_numRows; rowId += sampleStride) {
+				width = std::max(width, getCellWidth(column, rowId));
+			}
+			column.width = std::min(width, column.maxWidth);
+		}
+		m_bWidthsStale = FALSE;
+	}
+
+	// numeric cells as values, FALSE if any non empty cell isn't a finite decimal number.
+	// (NaN would break the ordering sorting relies on)
+	static BOOL parseNumbers(const TableColumn& column, int numRows, std::vector<double>& values)
+	{
+		values.resize(numRows);
+		wchar_t cell[64];
+		for (int rowId = 0; rowId < numRows; rowId++) {
+			size_t len;
+			const wchar_t* text = getCellText(column, rowId, len);
+			if (len == 0) {
+				values[rowId] = -HUGE_VAL; // empty cells first
+				continue;
+			}
+			if (len >= 64 || iswspace(text[0])) {
+				return FALSE;
+			}
+			std::copy(text, text + len, cell);
+			cell[len] = L'\0';
+			if (wcspbrk(cell, L"xX")) {
+				return FALSE; // hexadecimal
+			}
+			wchar_t* end;
+			values[rowId] = wcstod(cell, &end);
+			if (end != cell + len || !std::isfinite(values[rowId])) {
+				return FALSE;
+			}
+		}
+		return TRUE;
+	}
+
+	// sorts rows by column - numerically if all its cells are numbers, else by text.
+	// sorting again by same column reverses order. hovered row stays hovered.
+	void sortByColumn(int colIdx)
+	{
+		int hoveredRowId = getRowAt(getHoveredOptionIdx());
+		if (m_order.empty()) {
+			m_order.resize(m_numRows);
+			for (int rowId = 0; rowId < m_numRows; rowId++) {
+				m_order[rowId] = rowId;
+			}
+		}
+
+		if (colIdx == m_sortColumn) {
+			std::reverse(m_order.begin(), m_order.end());
+			m_bSortDescending = !m_bSortDescending;
+		}
+		else {
+			const TableColumn& column = m_columns[colIdx];
+			std::vector<double> values;
+			if (parseNumbers(column, m_numRows, values)) {
+				std::stable_sort(m_order.begin(), m_order.end(), [&values](int a, int b) {
+					return values[a] < values[b];
+				});
+			}
+			else {
+				std::stable_sort(m_order.begin(), m_order.end(), [&column](int a, int b) {
+					size_t lenA, lenB;
+					const wchar_t* textA = getCellText(column, a, lenA);
+					const wchar_t* textB = getCellText(column, b, lenB);
+					int cmp = wmemcmp(textA, textB, std::min(lenA, lenB));
+					return cmp != 0 ? cmp < 0 : lenA < lenB;
+				});
+			}
+			m_sortColumn = colIdx;
+			m_bSortDescending = FALSE;
+		}
+
+		int pos = (int)(std::find(m_order.begin(), m_order.end(), hoveredRowId) - m_order.begin());
+		m_currentPageIdx = pos / m_OPTIONS_PER_PAGE;
+		m_menuCursorPos = pos % m_OPTIONS_PER_PAGE;
+	}
+
+	// cell aligned within its column, truncated to column width
+	void renderCell(int row, int col, const TableColumn& column, int rowId)
+	{
+		size_t len;
+		const wchar_t* text = getCellText(column, rowId, len);
+		Truncation truncation = getTruncation(text, len, column.width);
+		if (truncation.bMarked) {
+			truncation = getTruncation(text, len, column.width - 1/*truncation mark*/);
+		}
+		if (!truncation.bMarked && column.alignment == ALIGN_RIGHT) {
+			col += column.width - truncation.width;
+		}
+		renderTruncated(row, col, text, len, truncation);
+	}
+
+protected:
+
+	// columns, not an option list
+	BOOL hasOptionList() const override {
+		return FALSE;
+	}
+
+	// styles are keyed by row id, whose position moves once sorted
+	void onOptionStyled(int rowId) override {
+		invalidateLayout();
+	}
+
+	int getOptionCount() const override {
+		return m_numRows;
+	}
+
+	// bulk options fill the first two columns, like 'addOption()'
+	void insertOption(std::wstring&& optDisplayName, std::wstring&& optDescription,
+		BOOL isSelectedByDefault) override
+	{
+		addRow({ std::move(optDisplayName), std::move(optDescription) }, isSelectedByDefault);
+	}
+
+	void reserveOptions(size_t count) override {
+		reserveRows(count);
+	}
+
+	void paintFrame() override
+	{
+		if (m_bLayoutDirty) {
+			renderTitle(); // column focus or sort order may have changed
+		}
+		VerticalMenu::paintFrame();
+	}
+
+	// title, then column headers - focused one in brackets, sorted one marked by direction
+	void renderTitle() override
+	{
+		if (m_bWidthsStale) {
+			updateColumnWidths();
+		}
+		m_screen.clearRow(0);
+		m_screen.clearRow(1);
+		m_screen.putText(0, 0, m_title.c_str(), m_title.length(), m_theme.title);
+
+		int col = 6/*cursor & checkbox*/;
+		for (int colIdx = 0; colIdx < (int)m_columns.size(); colIdx++) {
+			const TableColumn& column = m_columns[colIdx];
+			int headerWidth;
+			size_t headerLen = getFittingLength(column.header.c_str(), column.header.size(),
+				column.width, headerWidth);
+			headerWidth = std::min(headerWidth + (colIdx == m_sortColumn ? 2 : 0), column.width);
+			int headerCol = column.alignment == ALIGN_RIGHT ? col + column.width - headerWidth : col;
+			int end = m_screen.putText(1, headerCol, column.header.c_str(), headerLen);
+			if (colIdx == m_sortColumn) {
+				end = m_screen.putText(1, end, m_bSortDescending ? L" v" : L" ^", 
+					std::max(headerCol + headerWidth - end, 0));
+			}
+			if (colIdx == m_focusedColumn) {
+				m_screen.putChar(1, headerCol - 1, L'[');
+				m_screen.putChar(1, end, L']');
+				m_screen.applyStyle(1, headerCol, end - headerCol, m_theme.hoveredOption);
+			}
+			col += column.width + COLUMN_SPACING;
+		}
+	}
+
+	void renderOption(int optIdx) override
+	{
+		int row = getOptionRow(optIdx);
+		m_screen.clearRow(row);
+		int rowId = getRowAt(optIdx);
+
+		BOOL bHovered = m_menuCursorPos == optIdx % m_OPTIONS_PER_PAGE;
+		BOOL bSelected = m_selected[rowId];
+		int col = m_screen.putChar(row, 0, bHovered ? m_cursorStyle : L' ');
+		col = m_screen.putText(row, col, L" [", 2);
+		col = m_screen.putChar(row, col, bSelected ? L'*' : L' ');
+		col = m_screen.putText(row, col, L"] ", 2);
+		for (const TableColumn& column : m_columns) {
+			renderCell(row, col, column, rowId);
+			col += column.width + COLUMN_SPACING;
+		}
+
+		if (isStyled()) {
+			styleOptionRow(row, rowId, bHovered, bSelected, 3, 6, L"", 0, Truncation(),
+				std::min(col - COLUMN_SPACING, m_screen.getWidth()));
+		}
+	}
+
+	// full content of focused cell
+	void renderDescription(int optIdx) override
+	{
+		deleteDescription();
+		if (optIdx >= getOptionCount() || m_columns.empty()) {
+			return;
+		}
+		int row = getDescriptionRow();
+		const TableColumn& column = m_columns[m_focusedColumn];
+		size_t len;
+		const wchar_t* text = getCellText(column, getRowAt(optIdx), len);
+		int col = m_screen.putText(row, 0, column.header.c_str(), column.header.size());
+		col = m_screen.putText(row, col, L": ", 2);
+		col = renderTruncated(row, col, text, len, m_screen.getWidth() - col - 1/*truncation mark*/);
+		m_screen.applyStyle(row, 0, col, m_theme.description);
+	}
+};
+
+/// <summary>
+/// serves vertical menus to many terminal sessions at once, from a small pool of threads.
+/// each session is a menu bound to its own handles (pipe, socket, ...) opened for
+/// overlapped I/O and speaking VT sequences. sessions are driven by I/O completions -
+/// keys read from a session step its menu, and its frames are written back asynchronously.
+/// </summary>
+class MenuServer
+{
+public:
+	// called once a session ended - 'bCompleted' is FALSE if its input was closed first.
+	// (called on a worker thread. the menu is no longer used by then, and may be destroyed)
+	typedef std::function<void(VerticalMenu& menu, BOOL bCompleted)> SessionHandler;
+
+	MenuServer() {}
+
+	~MenuServer() {
+		stop();
+	}
+
+	MenuServer(const MenuServer&) = delete;
+	MenuServer& operator=(const MenuServer&) = delete;
+
+	// starts worker threads, one per processor unless specified
+	BOOL start(int numThreads = 0)
+	{
+		if (m_hPort) {
+			return FALSE;
+		}
+		m_hPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+		if (!m_hPort) {
+			return FALSE;
+		}
+		if (numThreads <= 0) {
+			numThreads = std::max((int)std::thread::hardware_concurrency(), 1);
+		}
+		for (int i = 0; i < numThreads; i++) {
+			m_workers.emplace_back(&MenuServer::workerLoop, this);
+		}
+		return TRUE;
+	}
+
+	// ends remaining sessions (as not completed), then stops worker threads
+	void stop()
+	{
+		if (!m_hPort) {
+			return;
+		}
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			for (auto& entry : m_sessions) {
+				std::lock_guard<std::mutex> sessionLock(entry.second->mutex);
+				endSession(*entry.second, FALSE);
+			}
+			m_sessionsCv.wait(lock, [this] { return m_sessions.empty(); });
+		}
+		for (size_t i = 0; i < m_workers.size(); i++) {
+			PostQueuedCompletionStatus(m_hPort, 0, STOP_KEY, NULL);
+		}
+		for (auto& worker : m_workers) {
+			worker.join();
+		}
+		m_workers.clear();
+		CloseHandle(m_hPort);
+		m_hPort = NULL;
+	}
+
+	// presents 'menu' on a session, until done.
+	// handles must be opened for overlapped I/O, and may be the same handle.
+	// (they are not closed by the server)
+	BOOL addSession(VerticalMenu& menu, HANDLE hInput, HANDLE hOutput,
+		const SessionHandler& onEnd, int lineSize = DEFAULT_SESSION_LINE_SIZE)
+	{
+		std::shared_ptr<Session> session = std::make_shared<Session>();
+		session->server = this;
+		session->menu = &menu;
+		session->hInput = hInput;
+		session->hOutput = hOutput;
+		session->lineSize = lineSize;
+		session->onEnd = onEnd;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (!m_hPort) {
+				return FALSE;
+			}
+			session->id = m_nextSessionId++;
+			if (!CreateIoCompletionPort(hInput, m_hPort, session->id, 0)) {
+				return FALSE;
+			}
+			if (hOutput != hInput && !CreateIoCompletionPort(hOutput, m_hPort, session->id, 0)) {
+				return FALSE;
+			}
+			m_sessions[session->id] = session;
+		}
+		{
+			std::lock_guard<std::mutex> sessionLock(session->mutex);
+			BasicMenu& basicMenu = menu;
+			HANDLE hPort = m_hPort;
+			ULONG_PTR sessionId = session->id;
+			basicMenu.setEndpoint(*session);
+			basicMenu.setWakeHandler([hPort, sessionId] {
+				PostQueuedCompletionStatus(hPort, 0, sessionId, NULL);
+			});
+			menu.start();
+			readSession(*session);
+			pumpSession(*session);
+		}
+		retireSession(session);
+		return TRUE;
+	}
+
+	size_t getSessionCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_sessions.size();
+	}
+
+private:
+	static const ULONG_PTR STOP_KEY = 0;
+	static const ULONG_PTR TIMER_KEY = 1;	// only wakes a worker to recompute its timeout
+
+	// state of VT input decoder
+	enum EscapeState { ESCAPE_NONE, ESCAPE_START, ESCAPE_CSI };
+
+	struct Session : public MenuEndpoint
+	{
+		ULONG_PTR id = 0;
+		MenuServer* server = NULL;
+		VerticalMenu* menu = NULL;
+		HANDLE hInput = NULL;
+		HANDLE hOutput = NULL;
+		int lineSize = DEFAULT_SESSION_LINE_SIZE;
+		SessionHandler onEnd;
+		std::mutex mutex;
+
+		OVERLAPPED readOverlapped;
+		OVERLAPPED writeOverlapped;
+		char readBuffer[SESSION_READ_BUFFER_SIZE];
+		std::vector<int> keys;
+		EscapeState escapeState = ESCAPE_NONE;
+		char prevChar = 0;
+
+		std::wstring frame;		// written by menu since last flush
+		std::string pending;	// encoded, waits for write in flight
+		std::string writing;	// owned by write in flight
+
+		BOOL bReading = FALSE;
+		BOOL bWriting = FALSE;
+		BOOL bEnded = FALSE;
+		BOOL bCompleted = FALSE;
+		BOOL bRetired = FALSE;
+		ULONGLONG wakeAtMs = 0;	// 0 if no wake is scheduled
+
+		void write(const wchar_t* str, size_t len) override {
+			frame.append(str, len);
+		}
+
+		void flush() override {
+			server->writeSession(*this);
+		}
+
+		int getLineSize() override {
+			return lineSize;
+		}
+
+		int getCursorRow() override {
+			return -1;
+		}
+
+		void setCursorVisible(BOOL bVisible) override {
+			frame.append(bVisible ? L"\033[?25h" : L"\033[?25l");
+		}
+
+		BOOL isBusy() override {
+			return bWriting;
+		}
+	};
+
+	HANDLE m_hPort = NULL;
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_sessionsCv;
+	std::unordered_map<ULONG_PTR, std::shared_ptr<Session>> m_sessions;
+	ULONG_PTR m_nextSessionId = TIMER_KEY + 1;
+
+	// scheduled wakes (due time, session), earliest first
+	typedef std::pair<ULONGLONG, ULONG_PTR> Wake;
+	std::mutex m_wakesMutex;
+	std::priority_queue<Wake, std::vector<Wake>, std::greater<Wake>> m_wakes;
+
+	void workerLoop()
+	{
+		while (true) {
+			DWORD numBytes = 0;
+			ULONG_PTR key = TIMER_KEY;
+			LPOVERLAPPED pOverlapped = NULL;
+			BOOL bOk = GetQueuedCompletionStatus(m_hPort, &numBytes, &key, &pOverlapped, 
+				getMillisUntilWake());
+			if (bOk && key == STOP_KEY) {
+				return;
+			}
+			if (key != TIMER_KEY && (bOk || pOverlapped)) {
+				std::shared_ptr<Session> session = findSession(key);
+				if (session) {
+					{
+						std::lock_guard<std::mutex> sessionLock(session->mutex);
+						if (pOverlapped == &session->readOverlapped) {
+							onRead(*session, bOk ? numBytes : 0);
+						}
+						else if (pOverlapped == &session->writeOverlapped) {
+							onWritten(*session, bOk);
+						}
+						else if (!session->bEnded) {
+							pumpSession(*session);
+						}
+					}
+					retireSession(session);
+				}
+			}
+			runDueWakes();
+		}
+	}
+
+	std::shared_ptr<Session> findSession(ULONG_PTR sessionId)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_sessions.find(sessionId);
+		return it == m_sessions.end() ? nullptr : it->second;
+	}
+
+	// SESSION I/O
+	// (expect session's mutex to be held)
+
+	void readSession(Session& session)
+	{
+		ZeroMemory(&session.readOverlapped, sizeof(session.readOverlapped));
+		if (!ReadFile(session.hInput, session.readBuffer, sizeof(session.readBuffer), 
+			NULL, &session.readOverlapped) && GetLastError() != ERROR_IO_PENDING) {
+			endSession(session, FALSE);
+			return;
+		}
+		session.bReading = TRUE;
+	}
+
+	void onRead(Session& session, DWORD numBytes)
+	{
+		session.bReading = FALSE;
+		if (numBytes == 0 || session.bEnded) {
+			endSession(session, FALSE);
+			return;
+		}
+		decodeKeys(session, numBytes);
+		for (int key : session.keys) {
+			if (session.menu->handleKey(key)) {
+				session.menu->finish();
+				endSession(session, TRUE);
+				return;
+			}
+		}
+		readSession(session);
+		pumpSession(session);
+	}
+
+	// encodes what the menu wrote, and writes it - unless a write is already in flight
+	void writeSession(Session& session)
+	{
+		if (!session.frame.empty()) {
+			int frameLen = (int)session.frame.size();
+			int numBytes = WideCharToMultiByte(CP_UTF8, 0, session.frame.data(), frameLen, 
+				NULL, 0, NULL, NULL);
+			size_t offset = session.pending.size();
+			session.pending.resize(offset + numBytes);
+			WideCharToMultiByte(CP_UTF8, 0, session.frame.data(), frameLen, 
+				&session.pending[offset], numBytes, NULL, NULL);
+			session.frame.clear();
+		}
+		if (session.bWriting || session.pending.empty() || (session.bEnded && !session.bCompleted)) {
+			return;
+		}
+		session.writing.swap(session.pending);
+		session.pending.clear();
+		ZeroMemory(&session.writeOverlapped, sizeof(session.writeOverlapped));
+		if (!WriteFile(session.hOutput, session.writing.data(), (DWORD)session.writing.size(), 
+			NULL, &session.writeOverlapped) && GetLastError() != ERROR_IO_PENDING) {
+			endSession(session, FALSE);
+			return;
+		}
+		session.bWriting = TRUE;
+	}
 
-		// adjust menu cursor position, if needed
-		if (m_menuCursorPos > numOptionsInPage - 1) {
-			m_menuCursorPos = numOptionsInPage - 1;
+	void onWritten(Session& session, BOOL bOk)
+	{
+		session.bWriting = FALSE;
+		if (!bOk) {
+			endSession(session, FALSE);
+			return;
 		}
+		// paints latest state, held back while writing
+		if (!session.bEnded) {
+			pumpSession(session);
+		}
+		writeSession(session);
+	}
 
-		for (int i = pageIdx * m_OPTIONS_PER_PAGE;
-			i < pageIdx * m_OPTIONS_PER_PAGE + numOptionsInPage;
-			i++
-		) {
-			renderOption(i);
+	// VT input -> keys, as returned by '_getch()' (arrows are prefixed by 224)
+	void decodeKeys(Session& session, DWORD numBytes)
+	{
+		session.keys.clear();
+		for (DWORD i = 0; i < numBytes; i++) {
+			char c = session.readBuffer[i];
+			switch (session.escapeState)
+			{
+			case ESCAPE_START:
+				if (c == '[' || c == 'O') {
+					session.escapeState = ESCAPE_CSI;
+					break;
+				}
+				session.keys.push_back(0x1B);
+				session.escapeState = ESCAPE_NONE;
+				// fall through
+			case ESCAPE_NONE:
+				if (c == 0x1B) {
+					session.escapeState = ESCAPE_START;
+				}
+				else if (c == '\r' || (c == '\n' && session.prevChar != '\r')) {
+					session.keys.push_back(KEY_ENTER);
+				}
+				else if (c != '\n') {
+					session.keys.push_back((unsigned char)c);
+				}
+				break;
+			case ESCAPE_CSI:
+				if (c >= 0x30 && c <= 0x3F) {
+					break; // parameters
+				}
+				session.escapeState = ESCAPE_NONE;
+				switch (c)
+				{
+				case 'A': session.keys.push_back(224); session.keys.push_back(KEY_ARROW_UP); break;
+				case 'B': session.keys.push_back(224); session.keys.push_back(KEY_ARROW_DOWN); break;
+				case 'C': session.keys.push_back(224); session.keys.push_back(KEY_ARROW_RIGHT); break;
+				case 'D': session.keys.push_back(224); session.keys.push_back(KEY_ARROW_LEFT); break;
+				}
+				break;
+			}
+			session.prevChar = c;
 		}
 	}
 
-	void hideMenuCursor() {
-		m_menuCursorPos = -1;
+	// paints what became pending, and schedules a wake for what is not due yet
+	void pumpSession(Session& session)
+	{
+		BasicMenu& menu = *session.menu;
+		if (WaitForSingleObject(menu.m_descriptionCache.getReadyEvent(), 0) == WAIT_OBJECT_0) {
+			menu.invalidateDescription();
+		}
+		DWORD timeout = menu.pumpFrame();
+		if (timeout != INFINITE) {
+			scheduleWake(session, timeout);
+		}
+	}
 
-		// refresh all options
-		renderPage(m_currentPageIdx);
+	void endSession(Session& session, BOOL bCompleted)
+	{
+		if (session.bEnded) {
+			return;
+		}
+		session.bEnded = TRUE;
+		session.bCompleted = bCompleted;
+		if (session.bReading) {
+			CancelIoEx(session.hInput, &session.readOverlapped);
+		}
+		if (!bCompleted) {
+			session.pending.clear();
+			if (session.bWriting) {
+				CancelIoEx(session.hOutput, &session.writeOverlapped);
+			}
+		}
 	}
 
-	void deleteDescription() override {
-		// move console cursor to line of description, and delete
-		moveConsoleCursorDown(
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size())
-			+ 1/*for spacing between options and description*/);
-		clearLine();
-		
-		// reset console cursor to initial position
-		moveConsoleCursorUp(
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size())
-			+ 1/*account for lines rendered above*/
-		);
+	// once ended, and no I/O is in flight, hands menu back to its owner
+	void retireSession(const std::shared_ptr<Session>& session)
+	{
+		{
+			std::lock_guard<std::mutex> sessionLock(session->mutex);
+			if (!session->bEnded || session->bReading || session->bWriting || session->bRetired) {
+				return;
+			}
+			session->bRetired = TRUE;
+			BasicMenu& menu = *session->menu;
+			menu.setWakeHandler(nullptr);
+			menu.setEndpoint(ConsoleEndpoint::instance());
+		}
+		if (session->onEnd) {
+			session->onEnd(*session->menu, session->bCompleted);
+		}
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_sessions.erase(session->id);
+		}
+		m_sessionsCv.notify_all();
 	}
 
-	void renderDescription(int optIdx) override {
-		deleteDescription();
-		
-		// move console cursor to line of description
-		moveConsoleCursorDown(
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size())
-			+ 1/*for spacing between options and description*/);
-		std::wcout << truncateString(m_options[optIdx]._description, getConsoleLineSize()) << std::endl;
+	// SCHEDULED WAKES
+	// (dropped frames and throttled live updates, painted once due)
 
-		// reset console cursor to initial position
-		moveConsoleCursorUp(
-			std::min(m_OPTIONS_PER_PAGE, (int)m_options.size()) 
-			+ 2/*account for lines rendered above*/
-		);
+	void scheduleWake(Session& session, DWORD delayMs)
+	{
+		ULONGLONG dueMs = GetTickCount64() + delayMs;
+		if (session.wakeAtMs != 0 && session.wakeAtMs <= dueMs) {
+			return;
+		}
+		session.wakeAtMs = dueMs;
+		BOOL bEarliest;
+		{
+			std::lock_guard<std::mutex> lock(m_wakesMutex);
+			bEarliest = m_wakes.empty() || dueMs < m_wakes.top().first;
+			m_wakes.push(Wake(dueMs, session.id));
+		}
+		if (bEarliest) {
+			PostQueuedCompletionStatus(m_hPort, 0, TIMER_KEY, NULL);
+		}
+	}
+
+	DWORD getMillisUntilWake()
+	{
+		std::lock_guard<std::mutex> lock(m_wakesMutex);
+		if (m_wakes.empty()) {
+			return INFINITE;
+		}
+		ULONGLONG nowMs = GetTickCount64();
+		return nowMs >= m_wakes.top().first ? 0 : (DWORD)(m_wakes.top().first - nowMs);
+	}
+
+	void runDueWakes()
+	{
+		ULONGLONG nowMs = GetTickCount64();
+		std::vector<ULONG_PTR> dueSessionIds;
+		{
+			std::lock_guard<std::mutex> lock(m_wakesMutex);
+			while (!m_wakes.empty() && m_wakes.top().first <= nowMs) {
+				dueSessionIds.push_back(m_wakes.top().second);
+				m_wakes.pop();
+			}
+		}
+		for (ULONG_PTR sessionId : dueSessionIds) {
+			std::shared_ptr<Session> session = findSession(sessionId);
+			if (!session) {
+				continue;
+			}
+			std::lock_guard<std::mutex> sessionLock(session->mutex);
+			// skip stale wakes, rescheduled since
+			if (!session->bEnded && session->wakeAtMs != 0 && session->wakeAtMs <= nowMs) {
+				session->wakeAtMs = 0;
+				pumpSession(*session);
+			}
+		}
 	}
 };
 
 /// <summary>
-/// Allows the user to choose any amount of option from a list of options.
+/// base class for horizontal menus
 /// </summary>
-class CheckboxMenu : public VerticalMenu
+class HorizontalMenu : public BasicMenu
 {
 public:
-	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle, 
-		int optsPerPage, const std::wstring& instruction) 
-		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, instruction) {};
+private:
+protected:
+	size_t m_maxOptLength = 8;
 
+	HorizontalMenu(const std::wstring& menuTitle)
+		: BasicMenu(menuTitle) {};
+	~HorizontalMenu() {};
 
-	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
-		: VerticalMenu(menuTitle, cursorStyle, optsPerPage) {};
+	void scrollConsole() override
+	{
+		int totalLines = 1/*title*/ + 1/*options*/ + 2/*description*/;
+		for (int i = 0; i < totalLines; i++) {
+			writeText(L"\n");
+		}
+		moveConsoleCursorUp(totalLines);
+	}
 
-	CheckboxMenu(const std::wstring& menuTitle, int optsPerPage,
-		const std::wstring& instruction)
-		: VerticalMenu(menuTitle, optsPerPage, instruction) {};
+	void renderTitle() override
+	{
+		writeStyled(m_title.c_str(), m_title.size(), m_theme.title);
+		writeText(L"  ");
+	}
 
-	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle, 
-		const std::wstring& instruction)
-		: VerticalMenu(menuTitle, cursorStyle, instruction) {};
+	// options follow one another on the line - a relabeled one moves those after it
+	void onOptionRelabeled(int optIdx) override {
+		invalidateLayout();
+	}
 
+	void paintFrame() override
+	{
+		if (m_bLayoutDirty) {
+			writeText(L"\033[K"); // clear what options covered, in case they shrunk
+		}
+		BasicMenu::paintFrame();
+	}
 
-	CheckboxMenu(const std::wstring& menuTitle, const std::wstring& instruction)
-		: VerticalMenu(menuTitle, instruction) {};
+	void renderOption(int optIdx) override
+	{
+		// move console cursor to line of selected option
+		int optStartPos = 0;
+		for (int i = 0; i < optIdx; i++) {
+			optStartPos += getOptionTruncation(i).width;
+			optStartPos += 4/*account for spacing between options*/;
+			if (i < getOptionCount() - 1) {
+				optStartPos += 3;
+			}
+		}
+		moveConsoleCursorRight(optStartPos);
 
-	CheckboxMenu(const std::wstring& menuTitle, int optsPerPage) 
-		: VerticalMenu(menuTitle, optsPerPage) {};
+		// display option
+		size_t nameLen;
+		const wchar_t* optName = getOptionName(optIdx, nameLen);
+		Truncation truncation = getOptionTruncation(optIdx);
+		int optLength = truncation.width + 4/*account for spacing between options*/;
+		clearRight(optLength);
 
-	CheckboxMenu(const std::wstring& menuTitle, wchar_t cursorStyle) 
-		: VerticalMenu(menuTitle, cursorStyle) {};
+		// option's style covers its cell, hovered style its brackets too
+		BOOL bHovered = m_menuCursorPos == optIdx;
+		auto styleIt = m_optionStyles.find(optIdx);
+		TextStyle cellStyle = styleIt != m_optionStyles.end() ? styleIt->second : TextStyle();
+		TextStyle topStyle = bHovered ? m_theme.hoveredOption : TextStyle();
+		TextStyle frameStyle = cellStyle.overlay(topStyle);
+
+		writeStyled(bHovered ? L"[ " : L"  ", 2, frameStyle);
+		size_t matchPos = m_matchQuery.empty() || m_theme.match.isPlain() ? 
+			std::wstring::npos : findMatch(optName, nameLen, m_matchQuery, 0);
+		writeNameRange(optIdx, optName, nameLen, 0, truncation.prefixLen, cellStyle, topStyle, matchPos);
+		if (truncation.bMarked) {
+			writeStyled(L"~", 1, frameStyle);
+			writeNameRange(optIdx, optName, nameLen, nameLen - truncation.suffixLen, nameLen, 
+				cellStyle, topStyle, matchPos);
+		}
+		writeStyled(bHovered ? L" ]" : L"  ", 2, frameStyle);
+
+		if (optIdx < getOptionCount() - 1) {
+			writeText(L" | ");
+			optLength += 3;
+		}
 
+		// reset console cursor to initial position
+		moveConsoleCursorLeft(optStartPos + optLength);
+	}
 
-	CheckboxMenu(const std::wstring& menuTitle)
-		: VerticalMenu(menuTitle) {};
+	// writes name's characters [start, end) in runs of equal style - option's spans & 
+	// matches drawn over 'cellStyle', 'topStyle' over all. 
+	// ('matchPos' is the match at or after 'start', found left to right like vertical menus do)
+	void writeNameRange(int optIdx, const wchar_t* name, size_t nameLen, size_t start, size_t end,
+		const TextStyle& cellStyle, const TextStyle& topStyle, size_t& matchPos)
+	{
+		auto spansIt = m_optionSpans.find(optIdx);
+		const std::vector<StyleSpan>* spans = spansIt != m_optionSpans.end() ? &spansIt->second : NULL;
+		size_t runStart = start;
+		TextStyle runStyle;
+		for (size_t i = start; i < end; i++) {
+			TextStyle style = cellStyle;
+			if (spans) {
+				for (const StyleSpan& span : *spans) {
+					if (i >= span.start && i < (size_t)span.start + span.length) {
+						style = style.overlay(span.style);
+					}
+				}
+			}
+			while (matchPos != std::wstring::npos && matchPos + m_matchQuery.size() <= i) {
+				matchPos = findMatch(name, nameLen, m_matchQuery, matchPos + m_matchQuery.size());
+			}
+			if (matchPos != std::wstring::npos && i >= matchPos) {
+				style = style.overlay(m_theme.match);
+			}
+			style = style.overlay(topStyle);
+
+			if (i > runStart && style != runStyle) {
+				writeStyled(name + runStart, i - runStart, runStyle);
+				runStart = i;
+			}
+			runStyle = style;
+		}
+		if (end > runStart) {
+			writeStyled(name + runStart, end - runStart, runStyle);
+		}
+	}
 
+	Truncation getOptionTruncation(int optIdx) const
+	{
+		size_t nameLen;
+		const wchar_t* name = getOptionName(optIdx, nameLen);
+		return getTruncation(name, nameLen, (int)m_maxOptLength, getOptionNameWidth(optIdx));
+	}
 
-	void addOption(const std::wstring& optDisplayName, 
-		const std::wstring& optDescription = L"", BOOL isSelectedByDefault = FALSE) {
-		VerticalMenu::addOption(optDisplayName, optDescription);
-		if (isSelectedByDefault) {
-			toggleOption(m_options.back());
+	void deleteDescription() override {	// DOES NOT RESET CONSOLE CURSOR
+		// move console cursor to line of selected option, and delete
+		moveConsoleCursorDown(2);
+		clearLine();
+	}
+
+	void renderDescription(int optIdx) override {
+		requestDescription(m_menuCursorPos);
+		deleteDescription();
+		size_t descLen;
+		const wchar_t* desc = getOptionDescription(m_menuCursorPos, descLen);
+		if (!m_theme.description.isPlain()) {
+			writeStyle(m_theme.description);
 		}
+		writeTruncated(desc, descLen, getConsoleLineSize());
+		if (!m_theme.description.isPlain()) {
+			writeStyle(TextStyle());
+		}
+		writeText(L"\r");
+
+		// reset console cursor to initial position
+		moveConsoleCursorUp(2/*account for lines rendered above*/);
+		moveConsoleCursorRight(m_title.size() + 2/*account for spacing - title to opts*/);
 	}
+};
+
+/// <summary>
+/// Single line prompt, allows the user to choose one option from a list of options.
+/// (practically, a horizontal RadioMenu. Best for short questions, like yes/no prompt.)
+/// </summary>
+class PromptMenu : public HorizontalMenu
+{
+public:
+	PromptMenu(const std::wstring& menuTitle) : HorizontalMenu(menuTitle) {};
 
 	void execute() override
 	{
-		char keyPress;
 		BOOL finitoLaComedia = FALSE;
 
+		start();
+		do
+		{
+			finitoLaComedia = handleKey(readKey());
+		} while (!finitoLaComedia);
+		finish();
+	}
+
+	// STEP-DRIVEN CONTROL
+	// (see 'VerticalMenu')
+
+	// paints initial frame. nothing is allocated by keys handled from here on.
+	void start()
+	{
+		m_dirtyOptions.reserve(getOptionCount());
 		hideConsoleCursor();
 		scrollConsole();
 		renderTitle();
-		renderPage(0);
+
+		// display all options
+		for (int i = 0; i < getOptionCount(); i++) {
+			renderOption(i);
+		}
 		renderDescription(0);
-		renderFooter();
+		m_endpoint->flush();
+	}
 
-		do
+	// MENU CONTROL
+	// (update state by a single key, returns TRUE once an option is selected)
+	BOOL handleKey(int keyPress)
+	{
+		BOOL finitoLaComedia = FALSE;
+
+		if (getOptionCount() == 0) {
+			return keyPress == KEY_ENTER;
+		}
+		switch (keyPress)
 		{
-			// MENU CONTROL
-			// (get user input & update state)
-			clearInputBuffer();
-			keyPress = _getch();
-			switch (keyPress)
-			{
-			case KEY_SPACEBAR:
-				toggleOption(m_options[m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos]);
+		case KEY_ARROW_LEFT:
+			if (m_menuCursorPos > 0) {
+				invalidateOption(m_menuCursorPos);
+				m_menuCursorPos--;
+				invalidateDescription();
 				break;
-			case KEY_ARROW_UP:
-				if (m_menuCursorPos > 0) {
-					m_menuCursorPos--;
-					renderOption(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos + 1);
-					break;
-				}
-				continue;
-			case KEY_ARROW_DOWN:
-				if (m_menuCursorPos < getNumOptionsInPage(m_currentPageIdx) - 1) {
-					m_menuCursorPos++;
-					renderOption(
-						m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos - 1);
-					break;
-				}
-				continue;
-			case KEY_ARROW_LEFT:
-				if (m_B_USE_PAGING && m_currentPageIdx > 0) {
-					m_currentPageIdx--;
-					renderPage(m_currentPageIdx);
-					renderFooter();
-					break;
-				}
-				continue;
-			case KEY_ARROW_RIGHT:
-				if (m_B_USE_PAGING && m_currentPageIdx < m_totalPages - 1) {
-					m_currentPageIdx++;
-					renderPage(m_currentPageIdx);
-					renderFooter();
-					break;
-				}
-				continue;
-			case KEY_ENTER:
-				finitoLaComedia = TRUE;
+			}
+			return FALSE;
+		case KEY_ARROW_RIGHT:
+			if (m_menuCursorPos < getOptionCount() - 1) {
+				invalidateOption(m_menuCursorPos);
+				m_menuCursorPos++;
+				invalidateDescription();
 				break;
-			default:
-				continue;
 			}
+			return FALSE;
+		// either of space/enter makes a selection
+		case KEY_SPACEBAR:
+		case KEY_ENTER:
+			selectOption(m_menuCursorPos);
+			finitoLaComedia = TRUE;
+			break;
+		default:
+			return FALSE;
+		}
 
-			renderOption(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos);
-			renderDescription(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos);
+		invalidateOption(m_menuCursorPos);
+		presentFrame(finitoLaComedia/*final state is always painted*/);
+		return finitoLaComedia;
+	}
 
-		} while (!finitoLaComedia);
+	// cleanup before exit
+	void finish()
+	{
+		deleteDescription();
+		showConsoleCursor();
+		m_endpoint->flush();
+	}
+
+private:
+protected:
+};
+
+/// <summary>
+/// text being edited, with a gap kept at the cursor - 
+/// inserting and deleting at the cursor is O(1), moving the cursor is O(distance).
+/// </summary>
+class GapBuffer
+{
+public:
+	size_t size() const {
+		return m_buffer.size() - getGapSize();
+	}
+
+	size_t getCursor() const {
+		return m_gapStart;
+	}
+
+	wchar_t at(size_t idx) const {
+		return idx < m_gapStart ? m_buffer[idx] : m_buffer[idx + getGapSize()];
+	}
+
+	// inserts before cursor
+	void insert(wchar_t ch)
+	{
+		if (m_gapStart == m_gapEnd) {
+			grow();
+		}
+		m_buffer[m_gapStart++] = ch;
+	}
+
+	// backspace
+	BOOL eraseBefore()
+	{
+		if (m_gapStart == 0) {
+			return FALSE;
+		}
+		m_gapStart--;
+		return TRUE;
+	}
+
+	// delete
+	BOOL eraseAfter()
+	{
+		if (m_gapEnd == m_buffer.size()) {
+			return FALSE;
+		}
+		m_gapEnd++;
+		return TRUE;
+	}
+
+	void moveCursor(size_t pos)
+	{
+		pos = std::min(pos, size());
+		while (m_gapStart > pos) {
+			m_buffer[--m_gapEnd] = m_buffer[--m_gapStart];
+		}
+		while (m_gapStart < pos) {
+			m_buffer[m_gapStart++] = m_buffer[m_gapEnd++];
+		}
+	}
+
+	void clear()
+	{
+		m_gapStart = 0;
+		m_gapEnd = m_buffer.size();
+	}
+
+	// replaces whole text, cursor is placed at its end
+	void assign(const wchar_t* str, size_t len)
+	{
+		clear();
+		for (size_t i = 0; i < len; i++) {
+			insert(str[i]);
+		}
+	}
 
-		// cleanup before exit
-		//hideMenuCursor();
-		moveConsoleCursorDown(
-			getNumOptionsInPage(m_currentPageIdx) + 5/*JUST AFTER MENU*/);
-		showConsoleCursor();
+	// copies text into 'out', reusing its capacity
+	void copyTo(std::wstring& out) const
+	{
+		out.assign(m_buffer.data(), m_gapStart);
+		out.append(m_buffer.data() + m_gapEnd, m_buffer.size() - m_gapEnd);
 	}
 
 private:
-protected:
+	std::vector<wchar_t> m_buffer;
+	size_t m_gapStart = 0;
+	size_t m_gapEnd = 0;
+
+	size_t getGapSize() const {
+		return m_gapEnd - m_gapStart;
+	}
+
+	// doubles buffer, text after the gap moves to its end
+	void grow()
+	{
+		size_t oldSize = m_buffer.size();
+		size_t tailSize = oldSize - m_gapEnd;
+		m_buffer.resize(std::max(oldSize * 2, INITIAL_GAP_SIZE));
+		std::copy_backward(m_buffer.begin() + m_gapEnd, m_buffer.begin() + oldSize, m_buffer.end());
+		m_gapEnd = m_buffer.size() - tailSize;
+	}
 };
 
 /// <summary>
-/// Allows the user to choose one option from a list of options,
-/// where selecting one option deselects any previously selected option.
+/// maps a prefix to the range of sorted candidates starting with it.
+/// candidates are sorted once, and indexed by a radix tree laid out in a flat array -
+/// children of a node are adjacent, labels are not copied but read from the candidates,
+/// and subtrees of up to COMPLETION_BUCKET_SIZE candidates are searched by bisection.
+/// lookup is O(prefix length * log(alphabet)), regardless of the amount of candidates.
 /// </summary>
-class RadioMenu : public VerticalMenu
+class CompletionIndex
 {
 public:
-	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
-		int optsPerPage, const std::wstring& instruction)
-		: VerticalMenu(menuTitle, cursorStyle, optsPerPage, instruction) {};
+	// candidate names must remain valid until the index is rebuilt.
+	// 'getName(idx, len)' returns name of candidate 'idx'.
+	template <typename NameAccessor>
+	void build(int count, NameAccessor getName)
+	{
+		m_candidates.clear();
+		m_candidates.reserve(count);
+		for (int idx = 0; idx < count; idx++) {
+			size_t len;
+			const wchar_t* name = getName(idx, len);
+			m_candidates.push_back({ name, (uint32_t)len, idx });
+		}
+		// (wmemcmp orders characters as compared below)
+		std::sort(m_candidates.begin(), m_candidates.end(),
+			[](const Candidate& a, const Candidate& b) {
+				int cmp = wmemcmp(a.name, b.name, std::min(a.len, b.len));
+				return cmp != 0 ? cmp < 0 : a.len < b.len;
+			});
+
+		m_nodes.clear();
+		m_nodes.push_back({ 0, (uint32_t)count, 0, 0, 0, 0 });
+
+		// breadth first, so children of each node are appended next to each other
+		for (size_t nodeIdx = 0; nodeIdx < m_nodes.size(); nodeIdx++) {
+			RadixNode node = m_nodes[nodeIdx];
+			if (node.last - node.first <= COMPLETION_BUCKET_SIZE) {
+				continue;
+			}
 
+			// candidates ending at node sort first, the rest are grouped by next character
+			uint32_t pos = node.first;
+			while (pos < node.last && m_candidates[pos].len == node.depth) {
+				pos++;
+			}
+			uint32_t firstChild = (uint32_t)m_nodes.size();
+			while (pos < node.last) {
+				wchar_t ch = m_candidates[pos].name[node.depth];
+				uint32_t end = (uint32_t)(std::partition_point(
+					m_candidates.begin() + pos, m_candidates.begin() + node.last,
+					[&node, ch](const Candidate& c) { return c.name[node.depth] == ch; }
+				) - m_candidates.begin());
+
+				// label spans common prefix of the group - that of its first and last candidates
+				const Candidate& first = m_candidates[pos];
+				const Candidate& last = m_candidates[end - 1];
+				uint32_t depth = node.depth + 1;
+				while (depth < first.len && depth < last.len && first.name[depth] == last.name[depth]) {
+					depth++;
+				}
+				m_nodes.push_back({ pos, end, 0, 0, depth, ch });
+				pos = end;
+			}
+			m_nodes[nodeIdx].firstChild = firstChild;
+			m_nodes[nodeIdx].numChildren = (uint32_t)m_nodes.size() - firstChild;
+		}
+	}
 
-	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle, int optsPerPage)
-		: VerticalMenu(menuTitle, cursorStyle, optsPerPage) {};
+	int size() const {
+		return (int)m_candidates.size();
+	}
 
-	RadioMenu(const std::wstring& menuTitle, int optsPerPage,
-		const std::wstring& instruction)
-		: VerticalMenu(menuTitle, optsPerPage, instruction) {};
+	// candidate index, by position in sorted order
+	int at(int pos) const {
+		return m_candidates[pos].idx;
+	}
 
-	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle,
-		const std::wstring& instruction)
-		: VerticalMenu(menuTitle, cursorStyle, instruction) {};
+	// positions [first, last) of candidates starting with 'prefix', in sorted order
+	void find(const wchar_t* prefix, size_t len, int& first, int& last) const
+	{
+		first = last = 0;
+		if (m_candidates.empty()) {
+			return;
+		}
+		const RadixNode* node = &m_nodes[0];
+		size_t pos = 0;
+		while (TRUE) {
+			// rest of node's label
+			const wchar_t* label = m_candidates[node->first].name;
+			size_t labelEnd = std::min((size_t)node->depth, len);
+			for (; pos < labelEnd; pos++) {
+				if (label[pos] != prefix[pos]) {
+					return;
+				}
+			}
+			if (pos == len) {
+				first = (int)node->first;
+				last = (int)node->last;
+				return;
+			}
+			if (node->numChildren == 0) {
+				findInBucket(*node, prefix, len, first, last);
+				return;
+			}
 
+			// children are ordered by first character
+			const RadixNode* children = &m_nodes[node->firstChild];
+			const RadixNode* childrenEnd = children + node->numChildren;
+			const RadixNode* child = std::lower_bound(children, childrenEnd, prefix[pos],
+				[](const RadixNode& n, wchar_t ch) { return n.firstChar < ch; });
+			if (child == childrenEnd || child->firstChar != prefix[pos]) {
+				return;
+			}
+			node = child;
+		}
+	}
 
-	RadioMenu(const std::wstring& menuTitle, const std::wstring& instruction)
-		: VerticalMenu(menuTitle, instruction) {};
+private:
+	struct Candidate
+	{
+		const wchar_t* name;
+		uint32_t len;
+		int idx;
+	};
 
-	RadioMenu(const std::wstring& menuTitle, int optsPerPage)
-		: VerticalMenu(menuTitle, optsPerPage) {};
+	// subtree of candidates [first, last), all sharing the first 'depth' characters
+	struct RadixNode
+	{
+		uint32_t first;
+		uint32_t last;
+		uint32_t firstChild;
+		uint32_t numChildren;
+		uint32_t depth;
+		wchar_t firstChar;
+	};
+
+	std::vector<Candidate> m_candidates;
+	std::vector<RadixNode> m_nodes;
+
+	// <0 if candidate sorts before all names starting with 'prefix', >0 if after, else 0
+	static int comparePrefix(const Candidate& c, const wchar_t* prefix, size_t len)
+	{
+		size_t count = std::min((size_t)c.len, len);
+		for (size_t i = 0; i < count; i++) {
+			if (c.name[i] != prefix[i]) {
+				return c.name[i] < prefix[i] ? -1 : 1;
+			}
+		}
+		return c.len < len ? -1 : 0;
+	}
 
-	RadioMenu(const std::wstring& menuTitle, wchar_t cursorStyle)
-		: VerticalMenu(menuTitle, cursorStyle) {};
+	void findInBucket(const RadixNode& node, const wchar_t* prefix, size_t len, 
+		int& first, int& last) const
+	{
+		auto begin = m_candidates.begin() + node.first;
+		auto end = m_candidates.begin() + node.last;
+		auto lower = std::partition_point(begin, end, [prefix, len](const Candidate& c) {
+			return comparePrefix(c, prefix, len) < 0;
+		});
+		auto upper = std::partition_point(lower, end, [prefix, len](const Candidate& c) {
+			return comparePrefix(c, prefix, len) == 0;
+		});
+		first = (int)(lower - m_candidates.begin());
+		last = (int)(upper - m_candidates.begin());
+	}
+};
 
+/// <summary>
+/// Free text input, completed from the added options. (e.g. a hostname out of an inventory)
+/// top completions are displayed below the input - up/down arrows cycle them,
+/// tab (or right arrow, at end of input) accepts the highlighted one.
+/// </summary>
+class InputMenu : public BasicMenu
+{
+public:
+	InputMenu(const std::wstring& menuTitle, int maxCompletions) 
+		: BasicMenu(menuTitle), m_MAX_COMPLETIONS(std::max(maxCompletions, 1)) {};
 
-	RadioMenu(const std::wstring& menuTitle)
-		: VerticalMenu(menuTitle) {};
+	InputMenu(const std::wstring& menuTitle) 
+		: InputMenu(menuTitle, DEFAULT_MAX_COMPLETIONS) {};
+
+	void addOption(const std::wstring& optDisplayName, const std::wstring& optDescription = L"") override {
+		BasicMenu::addOption(optDisplayName, optDescription);
+		m_bIndexStale = TRUE;
+	}
+
+	void addOption(const std::wstring& optDisplayName, const DescriptionProvider& descriptionProvider) override {
+		BasicMenu::addOption(optDisplayName, descriptionProvider);
+		m_bIndexStale = TRUE;
+	}
+
+	BOOL loadCatalog(OptionCatalog& catalog) override
+	{
+		if (!BasicMenu::loadCatalog(catalog)) {
+			return FALSE;
+		}
+		m_bIndexStale = TRUE;
+		return TRUE;
+	}
 
 	void execute() override
 	{
-		char keyPress;
 		BOOL finitoLaComedia = FALSE;
 
+		start();
+		do
+		{
+			finitoLaComedia = handleKey(readKey(TRUE));
+		} while (!finitoLaComedia);
+		finish();
+	}
+
+	// STEP-DRIVEN CONTROL
+	// (see 'VerticalMenu')
+
+	// paints initial frame. completions are indexed here, if options changed since.
+	void start()
+	{
 		hideConsoleCursor();
 		scrollConsole();
-		renderTitle();
-		renderPage(0);
-		renderDescription(0);
-		renderFooter();
+		m_bDone = FALSE;
+		m_keyPrefix = -1;
+		updateMatches();
+		invalidateLayout();
+		presentFrame(TRUE);
+	}
 
-		do
+	// updates state by a single key, as returned by '_getwch()'.
+	// returns TRUE once the input is submitted.
+	BOOL handleKey(int keyPress)
+	{
+		if (m_keyPrefix != -1) {
+			int keyPrefix = m_keyPrefix;
+			m_keyPrefix = -1;
+			if (!handleExtendedKey(keyPrefix, keyPress)) {
+				// not an extended key after all - the prefix was a character typed in
+				// (224 is also a valid character), followed by another one
+				insertChar(KEY_EXTENDED_PREFIX);
+				return handleKey(keyPress);
+			}
+		}
+		else
 		{
-			// MENU CONTROL
-			// (get user input & update state)
-			clearInputBuffer();
-			keyPress = _getch();
 			switch (keyPress)
 			{
-			case KEY_SPACEBAR:
-				// un-select selected option, if one is selected
- 				if (m_selectedOptIdx != -1) {
-					unselectOption(m_options[m_selectedOptIdx]);
-					if (isOptionInPage(
-						m_selectedOptIdx,
-						m_currentPageIdx)
-					) {
-						renderOption(m_selectedOptIdx);
-					}
+			case KEY_FUNCTION_PREFIX:
+			case KEY_EXTENDED_PREFIX:
+				m_keyPrefix = keyPress;
+				return FALSE;
+			case KEY_ENTER:
+				// a cycled completion is submitted, rather than the text typed
+				if (m_highlightedPos != -1) {
+					acceptCompletion();
 				}
-				toggleOption(m_options[m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos]);
-				m_selectedOptIdx = m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos;
+				m_bDone = TRUE;
 				break;
-			case KEY_ARROW_UP:
-				if (m_menuCursorPos > 0) {
-					m_menuCursorPos--;
-					renderOption(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos + 1);
-					break;
-				}
-				continue;
-			case KEY_ARROW_DOWN:
-				if (m_menuCursorPos < getNumOptionsInPage(m_currentPageIdx) - 1) {
-					m_menuCursorPos++;
-					renderOption(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos - 1);
-					break;
+			case KEY_TAB:
+				if (!acceptCompletion()) {
+					return FALSE;
 				}
-				continue;
-			case KEY_ARROW_LEFT:
-				if (m_currentPageIdx > 0) {
-					m_currentPageIdx--;
-					renderPage(m_currentPageIdx);
-					renderFooter();
-					break;
+				break;
+			case KEY_BACKSPACE:
+				if (!m_input.eraseBefore()) {
+					return FALSE;
 				}
-				continue;
-			case KEY_ARROW_RIGHT:
-				if (m_currentPageIdx < m_totalPages - 1) {
-					m_currentPageIdx++;
-					renderPage(m_currentPageIdx);
-					renderFooter();
-					break;
+				updateMatches();
+				break;
+			case KEY_ESCAPE:
+				// drops cycled completion, then typed text
+				if (m_highlightedPos != -1) {
+					highlightCompletion(-1);
 				}
-				continue;
-			case KEY_ENTER:
-				// prevent exit until an option is selected
-				if (m_selectedOptIdx != -1) {
-					finitoLaComedia = TRUE;
+				else {
+					m_input.clear();
+					updateMatches();
 				}
 				break;
 			default:
-				continue;
+				// ignore remaining control characters
+				if (keyPress < KEY_SPACEBAR) {
+					return FALSE;
+				}
+				insertChar((wchar_t)keyPress);
+				break;
 			}
+		}
 
-			renderOption(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos);
-			renderDescription(m_currentPageIdx * m_OPTIONS_PER_PAGE + m_menuCursorPos);
-
-		} while (!finitoLaComedia);
+		invalidateLayout();
+		presentFrame(m_bDone/*final state is always painted*/);
+		return m_bDone;
+	}
 
-		// cleanup before exit
-		//hideMenuCursor();
-		moveConsoleCursorDown(
-			getNumOptionsInPage(m_currentPageIdx) + 5/*JUST AFTER MENU*/);
+	// cleanup before exit
+	void finish()
+	{
+		deleteDescription();
+		m_screen.flush();
+		m_screen.moveCursor(getCompletionsRow(), 0);
+		m_endpoint->flush();
 		showConsoleCursor();
 	}
 
-private:
-	int m_selectedOptIdx = -1;
+	std::wstring getInput() const 
+	{
+		std::wstring input;
+		m_input.copyTo(input);
+		return input;
+	}
 
-protected:
-};
+	// submitted text, as the only option - selected. 
+	// its description is that of an option named the same, if any.
+	MenuState getState() override
+	{
+		std::wstring input = getInput();
+		const wchar_t* desc = L"";
+		size_t descLen = 0;
+		if (m_bIndexStale) {
+			buildIndex();
+		}
+		int first, last;
+		m_index.find(input.c_str(), input.size(), first, last);
+		if (first != last) {
+			// exact match sorts first
+			int optIdx = m_index.at(first);
+			size_t nameLen;
+			getOptionName(optIdx, nameLen);
+			if (nameLen == input.size()) {
+				desc = getOptionDescription(optIdx, descLen);
+			}
+		}
+		std::vector<Option> options;
+		options.push_back(makeOption(input, std::wstring(desc, descLen), TRUE));
+		return makeState(options);
+	}
 
-/// <summary>
-/// base class for horizontal menus
-/// </summary>
-class HorizontalMenu : public BasicMenu
-{
-public:
 private:
 protected:
-	size_t m_maxOptLength = 8;
+	const int m_MAX_COMPLETIONS;
+	GapBuffer m_input;
+	size_t m_inputScroll = 0;		// first input character displayed
+	int m_keyPrefix = -1;			// extended key prefix just read, if any
+	BOOL m_bDone = FALSE;
+
+	// completions of current input - positions in sorted order
+	CompletionIndex m_index;
+	BOOL m_bIndexStale = TRUE;
+	std::wstring m_inputScratch;
+	int m_matchesStart = 0;
+	int m_matchesEnd = 0;
+	int m_highlightedPos = -1;
+	int m_windowStart = 0;
+
+	// menu area, rendered by diffing frames
+	ScreenBuffer m_screen;
+
+	// returns FALSE if 'keyPress' isn't an extended key
+	BOOL handleExtendedKey(int keyPrefix, int keyPress)
+	{
+		switch (keyPress)
+		{
+		case KEY_ARROW_LEFT:
+			if (m_input.getCursor() > 0) {
+				m_input.moveCursor(m_input.getCursor() - 1);
+			}
+			break;
+		case KEY_ARROW_RIGHT:
+			if (m_input.getCursor() < m_input.size()) {
+				m_input.moveCursor(m_input.getCursor() + 1);
+			}
+			else {
+				acceptCompletion();
+			}
+			break;
+		case KEY_HOME:
+			m_input.moveCursor(0);
+			break;
+		case KEY_END:
+			m_input.moveCursor(m_input.size());
+			break;
+		case KEY_DELETE:
+			if (m_input.eraseAfter()) {
+				updateMatches();
+			}
+			break;
+		case KEY_ARROW_DOWN:
+			if (m_matchesStart != m_matchesEnd) {
+				highlightCompletion(m_highlightedPos == -1 || m_highlightedPos == m_matchesEnd - 1 ? 
+					m_matchesStart : m_highlightedPos + 1);
+			}
+			break;
+		case KEY_ARROW_UP:
+			if (m_matchesStart != m_matchesEnd) {
+				highlightCompletion(m_highlightedPos == -1 || m_highlightedPos == m_matchesStart ? 
+					m_matchesEnd - 1 : m_highlightedPos - 1);
+			}
+			break;
+		default:
+			// other function keys (F1, ...) are ignored
+			return keyPrefix == KEY_FUNCTION_PREFIX;
+		}
+		return TRUE;
+	}
 
-	HorizontalMenu(const std::wstring& menuTitle)
-		: BasicMenu(menuTitle) {};
-	~HorizontalMenu() {};
+	void insertChar(wchar_t ch)
+	{
+		m_input.insert(ch);
+		updateMatches();
+	}
 
-	void scrollConsole() override
+	void buildIndex()
 	{
-		int totalLines = 1/*title*/ + 1/*options*/ + 2/*description*/;
-		for (int i = 0; i < totalLines; i++) {
-			std::cout << "\n";
+		m_index.build(getOptionCount(), [this](int optIdx, size_t& len) {
+			return getOptionName(optIdx, len);
+		});
+		m_bIndexStale = FALSE;
+	}
+
+	// looks up completions of current input
+	void updateMatches()
+	{
+		if (m_bIndexStale) {
+			buildIndex();
 		}
-		moveConsoleCursorUp(totalLines);
+		m_input.copyTo(m_inputScratch);
+		m_index.find(m_inputScratch.c_str(), m_inputScratch.size(), m_matchesStart, m_matchesEnd);
+		m_highlightedPos = -1;
+		m_windowStart = m_matchesStart;
+		invalidateDescription();
 	}
 
-	void renderTitle() override
+	// -1 for none. completions are displayed by windows of 'm_MAX_COMPLETIONS'.
+	void highlightCompletion(int pos)
 	{
-		std::wcout << m_title << L"  ";
+		m_highlightedPos = pos;
+		if (pos != -1) {
+			m_windowStart = m_matchesStart + 
+				(pos - m_matchesStart) / m_MAX_COMPLETIONS * m_MAX_COMPLETIONS;
+		}
+		invalidateDescription();
 	}
 
-	void renderOption(int optIdx) override
+	// replaces input with highlighted completion (or first one, if none highlighted)
+	BOOL acceptCompletion()
 	{
-		// move console cursor to line of selected option
-		int optStartPos = 0;
-		for (int i = 0; i < optIdx; i++) {
-			optStartPos += 
-				truncateString(m_options[i]._displayName, m_maxOptLength).size();
-			optStartPos += 4/*account for spacing between options*/;
-			if (i < m_options.size() - 1) {
-				optStartPos += 3;
-			}
+		if (m_matchesStart == m_matchesEnd) {
+			return FALSE;
 		}
-		moveConsoleCursorRight(optStartPos);
+		int pos = m_highlightedPos != -1 ? m_highlightedPos : m_matchesStart;
+		size_t nameLen;
+		const wchar_t* name = getOptionName(m_index.at(pos), nameLen);
+		m_input.assign(name, nameLen);
+		updateMatches();
+		return TRUE;
+	}
 
-		// display option
-		std::wstring truncatedOpt = 
-			truncateString(m_options[optIdx]._displayName, m_maxOptLength);
-		int optLength = truncatedOpt.size()	+ 4/*account for spacing between options*/;
-		clearRight(optLength);
+	int getHoveredOptionIdx() override {
+		return m_highlightedPos != -1 ? m_index.at(m_highlightedPos) : -1;
+	}
 
-		if (m_menuCursorPos == optIdx) {
-			std::wcout << "[ " << truncatedOpt << " ]";
-		}
-		else {
-			std::wcout << "  " << truncatedOpt << "  ";
+	// relabeled options are displayed as completions only
+	BOOL isOptionDisplayed(int optIdx) override
+	{
+		int windowEnd = std::min(m_windowStart + m_MAX_COMPLETIONS, m_matchesEnd);
+		for (int pos = m_windowStart; pos < windowEnd; pos++) {
+			if (m_index.at(pos) == optIdx) {
+				return TRUE;
+			}
 		}
+		return FALSE;
+	}
 
-		if (optIdx < m_options.size() - 1) {
-			std::wcout << L" \| ";
-			optLength += 3;
-		}
+	void onOptionRelabeled(int optIdx) override {
+		m_bIndexStale = TRUE;
+	}
 
-		// reset console cursor to initial position
-		moveConsoleCursorLeft(optStartPos + optLength);
+	// index points into option names, which may have moved
+	void onOptionsAdded() override {
+		m_bIndexStale = TRUE;
 	}
 
-	void deleteDescription() override {	// DOES NOT RESET CONSOLE CURSOR
-		// move console cursor to line of selected option, and delete
-		moveConsoleCursorDown(2);
-		clearLine();
+	void setEndpoint(MenuEndpoint& endpoint) override
+	{
+		BasicMenu::setEndpoint(endpoint);
+		m_screen.setEndpoint(endpoint);
 	}
 
-	void renderDescription(int optIdx) override {
-		deleteDescription();
-		std::wcout << truncateString(m_options[m_menuCursorPos]._description, getConsoleLineSize()) << std::endl;
+	// MENU LAYOUT
+	// (title & input, then completions below - like horizontal menus)
 
-		// reset console cursor to initial position
-		moveConsoleCursorUp(3/*account for lines rendered above*/);
-		moveConsoleCursorRight(m_title.size() + 2/*account for spacing - title to opts*/);
+	int getInputCol() {
+		return (int)m_title.size() + 2/*for spacing between title and input*/;
 	}
-};
 
-/// <summary>
-/// Single line prompt, allows the user to choose one option from a list of options.
-/// (practically, a horizontal RadioMenu. Best for short questions, like yes/no prompt.)
-/// </summary>
-class PromptMenu : public HorizontalMenu
-{
-public:
-	PromptMenu(const std::wstring& menuTitle) : HorizontalMenu(menuTitle) {};
+	int getCompletionsRow() {
+		return 2;
+	}
 
-	void execute() override
+	int getMenuRows() {
+		return getCompletionsRow() + 1;
+	}
+
+	void scrollConsole() override
 	{
-		char keyPress;
-		BOOL finitoLaComedia = FALSE;
+		int totalLines = getMenuRows() + 1/*for spacing after menu*/;
+		std::wstring scroll(totalLines, L'\n');
+		scroll += L"\033[" + std::to_wstring(totalLines) + L"A";
+		m_endpoint->write(scroll.data(), scroll.size());
+		m_endpoint->flush();
+
+		// console cursor is now at first row of menu area
+		m_screen.resize(getConsoleLineSize() - 1/*avoid auto-wrap at last column*/, getMenuRows());
+		m_screen.setOrigin(m_endpoint->getCursorRow());
+	}
 
-		hideConsoleCursor();
-		scrollConsole();
+	// everything is repainted, the screen diff keeps output to what changed
+	void paintFrame() override
+	{
+		int width = getConsoleLineSize() - 1/*avoid auto-wrap at last column*/;
+		if (width > 0 && width != m_screen.getWidth()) {
+			m_screen.resize(width, getMenuRows());
+		}
 		renderTitle();
-
-		// display all options
-		for (int i = 0; i < m_options.size(); i++) {
-			renderOption(i);
+		renderInput();
+		if (m_bDone) {
+			deleteDescription();
 		}
-		renderDescription(0);
+		else {
+			renderDescription(getHoveredOptionIdx());
+		}
+		m_screen.flush();
+	}
 
-		do
-		{
-			// MENU CONTROL
-			// (get user input & update state)
-			clearInputBuffer();
-			keyPress = _getch();
-			switch (keyPress)
-			{
-			case KEY_ARROW_LEFT:
-				if (m_menuCursorPos > 0) {
-					m_menuCursorPos--;
-					renderOption(m_menuCursorPos + 1);
-					break;
-				}
-				continue;
-			case KEY_ARROW_RIGHT:
-				if (m_menuCursorPos < m_options.size() - 1) {
-					m_menuCursorPos++;
-					renderOption(m_menuCursorPos - 1);
-					break;
-				}
-				continue;
-			// either of space/enter makes a selection
-			case KEY_SPACEBAR:
-			case KEY_ENTER:
-				selectOption(m_options[m_menuCursorPos]);
-				finitoLaComedia = TRUE;
-				break;
-			default:
-				continue;
-			}
+	void renderTitle() override
+	{
+		m_screen.putText(0, 0, m_title.c_str(), m_title.size(), m_theme.title);
+	}
+
+	// input is scrolled horizontally to keep the cursor in view. 
+	// cursor is drawn in reverse video, console cursor stays hidden.
+	void renderInput()
+	{
+		int col = getInputCol();
+		int visibleCols = m_screen.getWidth() - col - 1/*cursor past end of input*/;
+		m_screen.fill(0, col, L' ', m_screen.getWidth() - col);
+		if (visibleCols <= 0) {
+			return;
+		}
+		size_t cursor = m_input.getCursor();
+		if (cursor < m_inputScroll) {
+			m_inputScroll = cursor;
+		}
+		int cursorOffset = 0;	// in columns, from first visible character
+		for (size_t i = m_inputScroll; i < cursor; i++) {
+			cursorOffset += getCharWidth(m_input.at(i));
+		}
+		int cursorWidth = cursor < m_input.size() ? getCharWidth(m_input.at(cursor)) : 1;
+		while (cursorOffset + cursorWidth > visibleCols && m_inputScroll < cursor) {
+			cursorOffset -= getCharWidth(m_input.at(m_inputScroll++));
+		}
+		int inputCol = col;
+		for (size_t i = m_inputScroll; i < m_input.size() && inputCol < col + visibleCols; i++) {
+			inputCol = m_screen.putChar(0, inputCol, m_input.at(i));
+		}
+		if (!m_bDone) {
+			m_screen.applyStyle(0, col + cursorOffset, cursorWidth,
+				TextStyle(COLOR_DEFAULT, COLOR_DEFAULT, ATTR_REVERSE));
+		}
+	}
 
-			renderOption(m_menuCursorPos);
-			renderDescription(m_menuCursorPos);
+	// (completions are rendered as a whole, by 'renderDescription()')
+	void renderOption(int optIdx) override {}
 
-		} while (!finitoLaComedia);
+	// current window of completions, highlighted one in brackets
+	void renderDescription(int optIdx) override
+	{
+		int row = getCompletionsRow();
+		m_screen.clearRow(row);
+		int col = 0;
+		int windowEnd = std::min(m_windowStart + m_MAX_COMPLETIONS, m_matchesEnd);
+		for (int pos = m_windowStart; pos < windowEnd; pos++) {
+			size_t nameLen;
+			const wchar_t* name = getOptionName(m_index.at(pos), nameLen);
+			BOOL bHighlighted = pos == m_highlightedPos;
+			int startCol = col;
+			col = m_screen.putChar(row, col, bHighlighted ? L'[' : L' ', m_theme.description);
+			int nameCol = col;
+			col = m_screen.putText(row, col, name, nameLen, m_theme.description);
+			m_screen.applyStyle(row, nameCol, 
+				getDisplayWidth(name, std::min(nameLen, m_inputScratch.size())), m_theme.match);
+			col = m_screen.putChar(row, col, bHighlighted ? L']' : L' ', m_theme.description);
+			if (bHighlighted) {
+				m_screen.applyStyle(row, startCol, col - startCol, m_theme.hoveredOption);
+			}
+			col = m_screen.putChar(row, col, L' ', m_theme.description);
+		}
 
-		deleteDescription();
-		showConsoleCursor();
+		int numMatches = m_matchesEnd - m_matchesStart;
+		if (numMatches > windowEnd - m_windowStart) {
+			wchar_t matchInfo[64];
+			int len = swprintf(matchInfo, 64, L"[ %d-%d / %d ]", 
+				m_windowStart - m_matchesStart + 1, windowEnd - m_matchesStart, numMatches);
+			m_screen.putText(row, col, matchInfo, std::max(len, 0), m_theme.footer);
+		}
 	}
 
-private:
-protected:
+	void deleteDescription() override {
+		m_screen.clearRow(getCompletionsRow());
+	}
 };
 
 #endif //RUBUBLIK_TXTPUTIZER_HPP_
\ No newline at end of file
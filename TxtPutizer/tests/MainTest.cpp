@@ -1,4 +1,31 @@
 #include "..\single_include\TxtPutizer\TxtPutizer.hpp"
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+
+// ALLOCATION COUNTING
+// (replaces global operator new, counting allocations while enabled)
+
+static std::atomic<bool> g_bCountAllocations(false);
+static std::atomic<long> g_numAllocations(0);
+
+void* operator new(size_t size)
+{
+	if (g_bCountAllocations) {
+		g_numAllocations++;
+	}
+	void* ptr = malloc(size ? size : 1);
+	if (ptr == NULL) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+	free(ptr);
+}
 
 void example_checkbox_menu()
 {
@@ -92,12 +119,358 @@ void example_prompt_menu()
 	std::wcout << "\r\nSELECTED OPTION: " << sel._displayName << std::endl;
 }
 
+void example_tree_menu()
+{
+	TreeMenu tm(L"TREE_MENU", 8);
+
+	// racks are loaded up front, their hosts only once expanded
+	tm.setChildrenLoader([&tm](int nodeId) {
+		for (int i = 1; i <= 4; i++) {
+			tm.addNode(nodeId, L"host" + std::to_wstring(i), L"host of node #" + std::to_wstring(nodeId));
+		}
+	});
+	for (int i = 1; i <= 3; i++) {
+		int cluster = tm.addNode(TREE_ROOT, L"cluster" + std::to_wstring(i), L"cluster", TRUE);
+		for (int j = 1; j <= 3; j++) {
+			tm.addNode(cluster, L"rack" + std::to_wstring(j), L"rack", TRUE);
+		}
+	}
+
+	tm.execute();
+	MenuState tmState = tm.getState();
+
+	for (Option opt : tmState.getSelectedOptions()) {
+		std::wcout << opt._displayName << L"\t " << opt._description << std::endl;
+	}
+}
+
+void example_styled_menu()
+{
+	CheckboxMenu cm(L"STYLED_MENU", 5);
+	for (int i = 0; i < 12; i++) {
+		cm.addOption(L"web" + std::to_wstring(i) + L".example.com", L"host #" + std::to_wstring(i));
+	}
+
+	MenuTheme theme;
+	theme.title = TextStyle(COLOR_CYAN, COLOR_DEFAULT, ATTR_BOLD);
+	theme.hoveredOption = TextStyle(COLOR_DEFAULT, COLOR_DEFAULT, ATTR_REVERSE);
+	theme.selectionMark = TextStyle(COLOR_GREEN, COLOR_DEFAULT, ATTR_BOLD);
+	theme.match = TextStyle(COLOR_YELLOW, COLOR_DEFAULT, ATTR_UNDERLINE);
+	theme.footer = TextStyle(COLOR_BRIGHT_BLACK);
+	cm.setTheme(theme);
+
+	// unavailable hosts are dimmed, domain of first host in red
+	cm.setOptionStyle(3, TextStyle(COLOR_DEFAULT, COLOR_DEFAULT, ATTR_DIM));
+	cm.setOptionStyle(7, TextStyle(COLOR_DEFAULT, COLOR_DEFAULT, ATTR_DIM));
+	cm.addOptionSpan(0, 4, 12, TextStyle(COLOR_RED));
+	cm.highlightMatches(L"b1");
+
+	cm.execute();
+	MenuState cmState = cm.getState();
+
+	for (Option opt : cmState.getSelectedOptions()) {
+		std::wcout << opt._displayName << std::endl;
+	}
+}
+
+void example_input_menu()
+{
+	InputMenu im(L"HOST");
+
+	const wchar_t* roles[] = { L"web", L"db", L"cache", L"api" };
+	for (const wchar_t* role : roles) {
+		for (int i = 1; i <= 50; i++) {
+			im.addOption(role + std::to_wstring(i) + L".example.com", L"a " + std::wstring(role) + L" host");
+		}
+	}
+
+	im.execute();
+	MenuState imState = im.getState();
+
+	for (Option opt : imState.getSelectedOptions()) {
+		std::wcout << opt._displayName << L"\t " << opt._description << std::endl;
+	}
+}
+
+// drives menus through a scripted session, expecting no allocations once first frame is drawn.
+// (checked in release builds too - returns false on failure)
+bool example_allocation_free_test()
+{
+	const int NUM_ROUNDS = 50;
+	const int KEYS[] = { 
+		KEY_ARROW_DOWN, KEY_SPACEBAR, KEY_ARROW_DOWN, KEY_ARROW_DOWN, KEY_SPACEBAR, 
+		KEY_ARROW_RIGHT, KEY_ARROW_DOWN, KEY_SPACEBAR, KEY_ARROW_RIGHT, KEY_ARROW_UP, 
+		KEY_ARROW_LEFT, KEY_ARROW_LEFT, KEY_SPACEBAR, KEY_ARROW_DOWN, KEY_ARROW_RIGHT 
+	};
+
+	CheckboxMenu cbm(L"ALLOCATION_FREE_CHECKBOX", 5, L"scripted session");
+	RadioMenu rm(L"ALLOCATION_FREE_RADIO", 5, L"scripted session");
+	for (int i = 0; i < 23; i++) {
+		// one option long enough to be truncated
+		std::wstring name = L"option" + std::to_wstring(i) + (i == 7 ? std::wstring(150, L'x') : L"");
+		cbm.addOption(name, L"description of " + name);
+		rm.addOption(name, L"description of " + name);
+	}
+	PromptMenu pm(L"ALLOCATION_FREE_PROMPT");
+	pm.addOption(L"yes", L"go on");
+	pm.addOption(L"no", L"stop");
+	pm.addOption(L"maybe later", L"ask again");
+
+	// every key paints a frame, none is dropped by pacing
+	cbm.setMaxFrameRate(0);
+	rm.setMaxFrameRate(0);
+	pm.setMaxFrameRate(0);
+
+	auto runSession = [&](VerticalMenu& menu) {
+		menu.start();
+		g_numAllocations = 0;
+		g_bCountAllocations = true;
+		for (int round = 0; round < NUM_ROUNDS; round++) {
+			for (int key : KEYS) {
+				menu.handleKey(key);
+			}
+		}
+		menu.handleKey(KEY_ENTER);
+		g_bCountAllocations = false;
+		menu.finish();
+		return (long)g_numAllocations;
+	};
+	long checkboxAllocations = runSession(cbm);
+	long radioAllocations = runSession(rm);
+
+	pm.start();
+	g_numAllocations = 0;
+	g_bCountAllocations = true;
+	for (int round = 0; round < NUM_ROUNDS; round++) {
+		for (int key : { KEY_ARROW_RIGHT, KEY_ARROW_RIGHT, KEY_ARROW_LEFT, KEY_ARROW_LEFT }) {
+			pm.handleKey(key);
+		}
+	}
+	pm.handleKey(KEY_ENTER);
+	g_bCountAllocations = false;
+	pm.finish();
+	long promptAllocations = g_numAllocations;
+
+	std::wcout << L"allocations - checkbox: " << checkboxAllocations << L", radio: " << radioAllocations 
+		<< L", prompt: " << promptAllocations << std::endl;
+	if (checkboxAllocations != 0 || radioAllocations != 0 || promptAllocations != 0) {
+		std::wcout << L"FAIL: allocations while handling keys" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void example_table_menu()
+{
+	TableMenu tm(L"TABLE_MENU", 8, L"tab: next column | s: sort");
+	tm.addColumn(L"HOST");
+	tm.addColumn(L"ROLE");
+	tm.addColumn(L"REGION", TableMenu::ALIGN_LEFT, 10);
+	tm.addColumn(L"LOAD", TableMenu::ALIGN_RIGHT);
+
+	const wchar_t* roles[] = { L"web", L"db", L"cache" };
+	const wchar_t* regions[] = { L"us-east-1", L"eu-central-1", L"ap-southeast-2" };
+	tm.reserveRows(100);
+	for (int i = 0; i < 100; i++) {
+		wchar_t load[16];
+		swprintf(load, 16, L"%.2f", (i * 37 % 100) / 10.0);
+		tm.addRow({ L"host" + std::to_wstring(i) + L".example.com", roles[i % 3], regions[i / 3 % 3], load });
+	}
+
+	tm.execute();
+	MenuState tmState = tm.getState();
+
+	for (Option opt : tmState.getSelectedOptions()) {
+		std::wcout << opt._displayName << std::endl;
+	}
+}
+
+void example_catalog_menu()
+{
+	// serialize a populated menu once...
+	CheckboxMenu source(L"CATALOG_SOURCE");
+	for (int i = 1; i <= 1000; i++) {
+		source.addOption(L"opt" + std::to_wstring(i), L"desc" + std::to_wstring(i), i % 7 == 0);
+	}
+	if (!OptionCatalog::write(L"example.cat", source)) {
+		std::wcout << L"failed writing catalog" << std::endl;
+		return;
+	}
+
+	// ...then present it, without re-adding any option
+	OptionCatalog catalog;
+	if (!catalog.open(L"example.cat")) {
+		std::wcout << L"failed opening catalog" << std::endl;
+		return;
+	}
+	CheckboxMenu cbm(L"CATALOG_MENU");
+	cbm.loadCatalog(catalog);
+	cbm.execute();
+
+	// selections are picked up by the next run
+	catalog.storeSelections();
+	std::wcout << L"SELECTED: " << cbm.getState().getSelectedOptions().size() << std::endl;
+}
+
+// load test - drives many concurrent sessions of a single server through local pipes,
+// and reports latency per session. (from a key written by a session's terminal,
+// until its next frame arrives back)
+void example_menu_server_load_test()
+{
+	const int NUM_SESSIONS = 2000;
+	const int NUM_CLIENT_THREADS = 8;
+	const int KEYS_PER_SESSION = 20;
+
+	struct LoadSession
+	{
+		std::unique_ptr<CheckboxMenu> menu;
+		HANDLE hServerPipe;
+		HANDLE hClientPipe;
+		std::vector<double> latenciesMs;
+	};
+	std::vector<LoadSession> sessions(NUM_SESSIONS);
+	std::atomic<int> numCompleted(0);
+
+	MenuServer server;
+	if (!server.start()) {
+		std::wcout << L"failed starting server" << std::endl;
+		return;
+	}
+	for (int i = 0; i < NUM_SESSIONS; i++) {
+		LoadSession& session = sessions[i];
+		std::wstring pipeName = L"\\\\.\\pipe\\txtputizer-load-" 
+			+ std::to_wstring(GetCurrentProcessId()) + L"-" + std::to_wstring(i);
+		session.hServerPipe = CreateNamedPipeW(pipeName.c_str(), PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED,
+			PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, 1, 4096, 4096, 0, NULL);
+		session.hClientPipe = CreateFileW(pipeName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL,
+			OPEN_EXISTING, 0, NULL);
+		if (session.hServerPipe == INVALID_HANDLE_VALUE || session.hClientPipe == INVALID_HANDLE_VALUE) {
+			std::wcout << L"failed creating pipe " << i << std::endl;
+			return;
+		}
+		session.menu.reset(new CheckboxMenu(L"SESSION " + std::to_wstring(i), 5));
+		for (int j = 1; j <= 20; j++) {
+			session.menu->addOption(L"opt" + std::to_wstring(j), L"desc" + std::to_wstring(j));
+		}
+		server.addSession(*session.menu, session.hServerPipe, session.hServerPipe,
+			[&numCompleted](VerticalMenu& menu, BOOL bCompleted) {
+				if (bCompleted) {
+					numCompleted++;
+				}
+			});
+	}
+
+	// each client thread plays the terminals of a slice of sessions
+	auto drainOutput = [](HANDLE hPipe) {
+		char buffer[4096];
+		DWORD numAvailable = 0, numRead = 0;
+		while (PeekNamedPipe(hPipe, NULL, 0, NULL, &numAvailable, NULL) && numAvailable > 0) {
+			ReadFile(hPipe, buffer, sizeof(buffer), &numRead, NULL);
+		}
+	};
+	auto playTerminals = [&](int first, int last) {
+		std::vector<std::chrono::steady_clock::time_point> sentAt(last - first);
+		std::vector<int> awaiting;
+		DWORD numBytes = 0;
+		for (int keyIdx = 0; keyIdx < KEYS_PER_SESSION; keyIdx++) {
+			const char* key = keyIdx % 2 == 0 ? "\033[B" : "\033[A"; // down, up
+			for (int i = first; i < last; i++) {
+				drainOutput(sessions[i].hClientPipe);
+				sentAt[i - first] = std::chrono::steady_clock::now();
+				WriteFile(sessions[i].hClientPipe, key, 3, &numBytes, NULL);
+				awaiting.push_back(i);
+			}
+			// poll terminals, so each frame is timed as soon as it arrives
+			while (!awaiting.empty()) {
+				for (size_t j = 0; j < awaiting.size();) {
+					int i = awaiting[j];
+					DWORD numAvailable = 0;
+					if (!PeekNamedPipe(sessions[i].hClientPipe, NULL, 0, NULL, &numAvailable, NULL)
+						|| numAvailable > 0) {
+						std::chrono::duration<double, std::milli> latency = 
+							std::chrono::steady_clock::now() - sentAt[i - first];
+						sessions[i].latenciesMs.push_back(latency.count());
+						drainOutput(sessions[i].hClientPipe);
+						awaiting[j] = awaiting.back();
+						awaiting.pop_back();
+					}
+					else {
+						j++;
+					}
+				}
+				std::this_thread::yield();
+			}
+		}
+		for (int i = first; i < last; i++) {
+			WriteFile(sessions[i].hClientPipe, "\r", 1, &numBytes, NULL);
+		}
+	};
+
+	Sleep(500); // let initial frames arrive
+	for (auto& session : sessions) {
+		drainOutput(session.hClientPipe);
+	}
+	std::vector<std::thread> clients;
+	int sliceSize = (NUM_SESSIONS + NUM_CLIENT_THREADS - 1) / NUM_CLIENT_THREADS;
+	for (int first = 0; first < NUM_SESSIONS; first += sliceSize) {
+		clients.emplace_back(playTerminals, first, std::min(first + sliceSize, NUM_SESSIONS));
+	}
+	for (auto& client : clients) {
+		client.join();
+	}
+	for (int waitedMs = 0; server.getSessionCount() > 0 && waitedMs < 5000; waitedMs += 10) {
+		Sleep(10);
+	}
+	server.stop();
+
+	// REPORT
+	std::vector<double> allLatencies;
+	std::vector<std::pair<double, int>> sessionMeans;
+	for (int i = 0; i < NUM_SESSIONS; i++) {
+		const std::vector<double>& latencies = sessions[i].latenciesMs;
+		double sum = 0;
+		for (double latency : latencies) {
+			sum += latency;
+		}
+		allLatencies.insert(allLatencies.end(), latencies.begin(), latencies.end());
+		sessionMeans.push_back({ latencies.empty() ? 0 : sum / latencies.size(), i });
+		CloseHandle(sessions[i].hClientPipe);
+		CloseHandle(sessions[i].hServerPipe);
+	}
+	if (allLatencies.empty()) {
+		std::wcout << L"no frames received" << std::endl;
+		return;
+	}
+	std::sort(allLatencies.begin(), allLatencies.end());
+	std::sort(sessionMeans.rbegin(), sessionMeans.rend());
+	auto percentile = [&allLatencies](double p) {
+		return allLatencies[std::min((size_t)(p * allLatencies.size()), allLatencies.size() - 1)];
+	};
+	std::wcout << L"sessions: " << NUM_SESSIONS << L", completed: " << numCompleted 
+		<< L", frames: " << allLatencies.size() << std::endl;
+	std::wcout << L"latency (ms) - p50: " << percentile(0.5) << L", p99: " << percentile(0.99) 
+		<< L", max: " << allLatencies.back() << std::endl;
+	std::wcout << L"slowest sessions (mean ms):";
+	for (size_t i = 0; i < 5 && i < sessionMeans.size(); i++) {
+		std::wcout << L" #" << sessionMeans[i].second << L"=" << sessionMeans[i].first;
+	}
+	std::wcout << std::endl;
+}
 
 int main()
 {
 	example_checkbox_menu();
 	//example_radio_menu();
 	//example_prompt_menu();
+	//example_tree_menu();
+	//example_styled_menu();
+	//example_input_menu();
+	//example_table_menu();
+	//example_catalog_menu();
+	//example_menu_server_load_test();
+	if (!example_allocation_free_test()) {
+		return 1;
+	}
 
 	return 0;
 }